@@ -22,7 +22,6 @@ namespace UnrealBuildTool.Rules
 				new string[] {
 					"PolyToolkit/Private",
 					"PolyToolkit/ThirdParty/gltf2-loader/include",
-					"PolyToolkit/ThirdParty/gltf2-loader/ext",
 					"PolyToolkit/ThirdParty/tinygltfloader",
 					}
 			);
@@ -23,7 +23,10 @@
 #include "ProceduralMeshComponent.h"
 #include "IImageWrapperModule.h"
 #include "IImageWrapper.h"
-#include <cstring>
+#include "PolyMaterialCache.h"
+#include "PolyToolkit.h"
+#include "PolyToolkitStats.h"
+#include "Async/ParallelFor.h"
 
 UGltf1Importer::UGltf1Importer(const class FObjectInitializer& PCIP) : Super(PCIP)
 {
@@ -44,9 +47,17 @@ UGltf1Importer::UGltf1Importer(const class FObjectInitializer& PCIP) : Super(PCI
 	{
 		GemMaterial = GemMaterialFinder.Object;
 	}
+	NextPendingComponent = 0;
 }
 
-void UGltf1Importer::ImportModel(const FPolyFormat& File, const FString& AssetName, AActor* PolyActor)
+void UGltf1Importer::BeginImport(const FPolyImportOptions& ImportOptions)
+{
+	check(IsInGameThread());
+	Options = ImportOptions;
+	MaterialInstances.Empty();
+}
+
+bool UGltf1Importer::ParseModel(const FPolyFormat& File, const FString& AssetName)
 {
 #if PLATFORM_ANDROID
 	FString BasePath = "/sdcard/UE4Game/HelloPolyToolkit/HelloPolyToolkit/Content/";
@@ -69,35 +80,190 @@ void UGltf1Importer::ImportModel(const FPolyFormat& File, const FString& AssetNa
 
 	if(!Ret){
 		UE_LOG(LogTemp, Warning, TEXT("Failed to parse glTF file"));
-		return;
+		return false;
+	}
+
+	DecodeScene();
+	return true;
+}
+
+// Reads the external files of a glTF from the downloaded resources.
+static bool ReadResource(std::vector<unsigned char>* Out, const std::string& FileName, void* UserData)
+{
+	const TMap<FString, FPolySharedContent>* Resources = static_cast<const TMap<FString, FPolySharedContent>*>(UserData);
+	const FPolySharedContent* Resource = Resources->Find(UTF8_TO_TCHAR(FileName.c_str()));
+	if(Resource == NULL)
+	{
+		return false;
+	}
+	Out->assign((*Resource)->GetData(), (*Resource)->GetData() + (*Resource)->Num());
+	return true;
+}
+
+bool UGltf1Importer::ParseModelFromMemory(const FPolyFormat& File, const TMap<FString, FPolySharedContent>& Resources)
+{
+	const FPolySharedContent* Root = Resources.Find(File.root.relativePath);
+	if(Root == NULL)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Root file %s was not downloaded"), *File.root.relativePath);
+		return false;
+	}
+
+	tinygltf::TinyGLTFLoader Loader;
+	Loader.SetReadExternalFileFunction(&ReadResource, const_cast<TMap<FString, FPolySharedContent>*>(&Resources));
+	std::string Err;
+	bool Ret = false;
+	Ret = Loader.LoadASCIIFromString(&Scene, &Err, reinterpret_cast<const char*>((*Root)->GetData()), (*Root)->Num(), "");
+
+	if(!Err.empty())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Error parsing glTF: %s"), UTF8_TO_TCHAR(Err.c_str()));
+	}
+
+	if(!Ret){
+		UE_LOG(LogTemp, Warning, TEXT("Failed to parse glTF file"));
+		return false;
+	}
+
+	DecodeScene();
+	return true;
+}
+
+void UGltf1Importer::DecodeScene()
+{
+	// Add every section first, the map must not grow while they are decoded.
+	MeshSections.Empty(Scene.meshes.size());
+	for(auto& Mesh : Scene.meshes)
+	{
+		MeshSections.Add(UTF8_TO_TCHAR(Mesh.first.c_str())).SetNum(Mesh.second.primitives.size());
 	}
 
+	// Decode every primitive on its own task, each into its own section.
+	TArray<TPair<const tinygltf::Primitive*, FGltfMeshSection*>> Primitives;
+	for(auto& Mesh : Scene.meshes)
+	{
+		TArray<FGltfMeshSection>& Sections = MeshSections[UTF8_TO_TCHAR(Mesh.first.c_str())];
+		for(int i = 0; i < Mesh.second.primitives.size(); i++)
+		{
+			Primitives.Add(TPair<const tinygltf::Primitive*, FGltfMeshSection*>(&Mesh.second.primitives[i], &Sections[i]));
+		}
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_PolyDecodePrimitives);
+	ParallelFor(Primitives.Num(), [this, &Primitives](int32 Index)
+	{
+		DecodePrimitive(*Primitives[Index].Key, *Primitives[Index].Value);
+	}, CVarPolyParallelDecode.GetValueOnAnyThread() == 0);
+}
+
+void UGltf1Importer::BeginCreateModel(AActor* PolyActor)
+{
+	check(IsInGameThread());
+
+	// Create root component.
+	RootMesh = NewObject<UProceduralMeshComponent>(PolyActor);
+	PolyActor->SetRootComponent(RootMesh);
+	RootMesh->RegisterComponent();
+
+	// List everything to create up front, parents before their children, so
+	// CreateComponents can stop and resume anywhere.
+	PendingComponents.Empty();
+	NextPendingComponent = 0;
 	if(!Scene.defaultScene.empty())
 	{
-		LoadScene(Scene.scenes[Scene.defaultScene], PolyActor);
+		for(auto& Node : Scene.scenes[Scene.defaultScene])
+		{
+			AddPendingNode(Scene.nodes[Node], INDEX_NONE);
+		}
 	}
 	else
 	{
 		UE_LOG(LogTemp, Warning, TEXT("No default scene"));
 	}
+
+	CreatedComponents.Empty();
+	CreatedComponents.SetNumZeroed(PendingComponents.Num());
 }
 
-void UGltf1Importer::LoadScene(const std::vector<std::string>& SceneNodes, AActor* PolyActor)
+void UGltf1Importer::AddPendingNode(const tinygltf::Node& Node, int32 Parent)
 {
-	// Create root component.
-	UProceduralMeshComponent* Mesh = NewObject<UProceduralMeshComponent>(PolyActor);
-	PolyActor->SetRootComponent(Mesh);
-	Mesh->RegisterComponent();
-	// Iterate through Nodes.
-	for(auto& Node : SceneNodes)
+	FPendingComponent NodeComponent;
+	NodeComponent.Parent = Parent;
+	NodeComponent.Node = &Node;
+	int32 NodeIndex = PendingComponents.Add(NodeComponent);
+
+	for(auto& MeshName : Node.meshes)
 	{
-		LoadNode(Scene.nodes[Node], Mesh);
+		const TArray<FGltfMeshSection>* Sections = MeshSections.Find(UTF8_TO_TCHAR(MeshName.c_str()));
+		if(Sections == NULL)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Mesh %s not found"), UTF8_TO_TCHAR(MeshName.c_str()));
+			continue;
+		}
+
+		const tinygltf::Mesh& Mesh = Scene.meshes[MeshName];
+		for(int i = 0; i < Mesh.primitives.size(); i++)
+		{
+			FPendingComponent PrimitiveComponent;
+			PrimitiveComponent.Parent = NodeIndex;
+			PrimitiveComponent.Primitive = &Mesh.primitives[i];
+			PrimitiveComponent.Section = &(*Sections)[i];
+			PendingComponents.Add(PrimitiveComponent);
+		}
+	}
+
+	for(auto& Child : Node.children)
+	{
+		AddPendingNode(Scene.nodes[Child], NodeIndex);
 	}
 }
 
-void UGltf1Importer::LoadNode(const tinygltf::Node& Node, USceneComponent* Parent)
+bool UGltf1Importer::CreateComponents(double EndTime)
 {
-	// Create Node component.
+	check(IsInGameThread());
+
+	// At least one component per call, so the import always moves forward.
+	while(NextPendingComponent < PendingComponents.Num())
+	{
+		const FPendingComponent& Pending = PendingComponents[NextPendingComponent];
+		USceneComponent* Parent = Pending.Parent != INDEX_NONE ? CreatedComponents[Pending.Parent] : RootMesh;
+		if(Pending.Node != NULL)
+		{
+			CreatedComponents[NextPendingComponent] = LoadNode(*Pending.Node, Parent);
+		}
+		else
+		{
+			LoadPrimitive(*Pending.Primitive, *Pending.Section, Parent);
+		}
+
+		NextPendingComponent++;
+		if(FPlatformTime::Seconds() >= EndTime)
+		{
+			break;
+		}
+	}
+
+	if(NextPendingComponent < PendingComponents.Num())
+	{
+		return false;
+	}
+
+	// The geometry now lives in the components.
+	MeshSections.Empty();
+	PendingComponents.Empty();
+	CreatedComponents.Empty();
+	NextPendingComponent = 0;
+	return true;
+}
+
+float UGltf1Importer::GetCreationProgress() const
+{
+	return PendingComponents.Num() > 0 ? static_cast<float>(NextPendingComponent) / PendingComponents.Num() : 1.0f;
+}
+
+USceneComponent* UGltf1Importer::LoadNode(const tinygltf::Node& Node, USceneComponent* Parent)
+{
+	// Create Node component, its meshes and children are created after it.
 	UProceduralMeshComponent* NodeComponent = NewObject<UProceduralMeshComponent>(Parent);
 	NodeComponent->SetupAttachment(Parent);
 	NodeComponent->RegisterComponent();
@@ -111,30 +277,23 @@ void UGltf1Importer::LoadNode(const tinygltf::Node& Node, USceneComponent* Paren
 		FTransform Transform(Rotation, Translation, Scale);
 		NodeComponent->SetRelativeTransform(Transform);
 	}
-
-	// Load meshes of component.
-	for(auto& Mesh : Node.meshes)
-	{
-		LoadMesh(Scene.meshes[Mesh], NodeComponent);
-	}
-
-	// Load children of this Node.
-	for (auto& Child : Node.children)
-	{
-		LoadNode(Scene.nodes[Child], NodeComponent);
-	}
+	return NodeComponent;
 }
 
-void UGltf1Importer::LoadMesh(const tinygltf::Mesh& Mesh, USceneComponent* Parent)
+// Accessor of the attribute Name of Primitive, NULL if it does not have it.
+// Only const lookups, primitives are decoded in parallel.
+static const tinygltf::Accessor* FindAttribute(const tinygltf::Scene& Scene, const tinygltf::Primitive& Primitive, const char* Name)
 {
-	// Load all the primitives of this mesh.
-	for(auto& Primitive : Mesh.primitives)
+	auto It = Primitive.attributes.find(Name);
+	if(It == Primitive.attributes.end())
 	{
-		LoadPrimitive(Primitive, Parent);
+		return NULL;
 	}
+	auto Accessor = Scene.accessors.find(It->second);
+	return Accessor != Scene.accessors.end() ? &Accessor->second : NULL;
 }
 
-void UGltf1Importer::LoadPrimitive(const tinygltf::Primitive& Primitive, USceneComponent* Parent)
+void UGltf1Importer::DecodePrimitive(const tinygltf::Primitive& Primitive, FGltfMeshSection& Section)
 {
 	if(Primitive.mode != TINYGLTF_MODE_TRIANGLES)
 	{
@@ -142,158 +301,153 @@ void UGltf1Importer::LoadPrimitive(const tinygltf::Primitive& Primitive, USceneC
 		return;
 	}
 
-	TArray<int32> Triangles;
-	if(!Primitive.indices.empty())
+	enum EAttribute
 	{
-		Triangles = LoadAttribute<int32,int32>(Scene.accessors[Primitive.indices]);
-	}
-
-	TArray<FVector> Vertices;
-	auto It = Primitive.attributes.find("POSITION");
-	if (It != Primitive.attributes.end())
+		Indices,
+		Positions,
+		Normals,
+		TextCoords,
+		Colors,
+		NumAttributes
+	};
+	auto IndicesAccessor = Scene.accessors.find(Primitive.indices);
+	const tinygltf::Accessor* Accessors[NumAttributes] =
 	{
-		Vertices = LoadAttribute<FVector, float>(Scene.accessors[It->second]);
-	}
-
-	TArray<FVector> Normals;
-	It = Primitive.attributes.find("NORMAL");
-	if (It != Primitive.attributes.end())
+		IndicesAccessor != Scene.accessors.end() ? &IndicesAccessor->second : NULL,
+		FindAttribute(Scene, Primitive, "POSITION"),
+		FindAttribute(Scene, Primitive, "NORMAL"),
+		FindAttribute(Scene, Primitive, "TEXCOORD_0"),
+		FindAttribute(Scene, Primitive, "COLOR")
+	};
+
+	// Every attribute has its own array, large primitives decode them in parallel.
+	const bool bSingleThread = CVarPolyParallelDecode.GetValueOnAnyThread() == 0 || Accessors[Positions] == NULL || Accessors[Positions]->count < GltfParallelAttributesMinVertices;
+	ParallelFor(NumAttributes, [this, &Accessors, &Section](int32 Attribute)
 	{
-		Normals = LoadAttribute<FVector, float>(Scene.accessors[It->second]);
-	}
+		if(Accessors[Attribute] == NULL)
+		{
+			return;
+		}
 
-	TArray<FVector2D> TextCoords;
-	It = Primitive.attributes.find("TEXCOORD_0");
-	if (It != Primitive.attributes.end())
-	{
-		TextCoords = LoadAttribute<FVector2D, float>(Scene.accessors[It->second]);
-	}
+		FGltfAccessorView View = GetAccessorView(*Accessors[Attribute]);
+		switch(Attribute)
+		{
+			case Indices:
+				Section.Triangles = LoadGltfAccessor<int32>(View);
+				break;
+			case Positions:
+				Section.Vertices = LoadGltfAccessor<FVector>(View);
+				break;
+			case Normals:
+				Section.Normals = LoadGltfAccessor<FVector>(View);
+				break;
+			case TextCoords:
+				Section.TextCoords = LoadGltfAccessor<FVector2D>(View);
+				break;
+			case Colors:
+				Section.VertexColors = LoadGltfAccessor<FColor>(View);
+				break;
+		}
+	}, bSingleThread);
+}
 
-	TArray<FColor> VertexColors;
-	It = Primitive.attributes.find("COLOR");
-	if(It != Primitive.attributes.end())
+void UGltf1Importer::LoadPrimitive(const tinygltf::Primitive& Primitive, const FGltfMeshSection& Section, USceneComponent* Parent)
+{
+	if(Primitive.mode != TINYGLTF_MODE_TRIANGLES)
 	{
-		VertexColors = LoadAttribute<FColor, float>(Scene.accessors[It->second]);
+		return;
 	}
 
 	//Create procedural mesh component for this primitive
 	UProceduralMeshComponent* Mesh = NewObject<UProceduralMeshComponent>(Parent);
-	Mesh->CreateMeshSection(0, Vertices, Triangles, Normals, TextCoords, VertexColors, TArray<FProcMeshTangent>(), false);
+	Mesh->CreateMeshSection(0, Section.Vertices, Section.Triangles, Section.Normals, Section.TextCoords, Section.VertexColors, TArray<FProcMeshTangent>(), false);
 	Mesh->SetupAttachment(Parent);
 	Mesh->RegisterComponent();
 
 	UMaterialInstanceDynamic* MaterialInstance = NULL;
 	if (!Primitive.material.empty())
 	{
-		MaterialInstance = LoadMaterial(Scene.materials[Primitive.material], Mesh);
+		MaterialInstance = GetMaterial(Scene.materials[Primitive.material], Mesh);
 	}
 
 	Mesh->SetMaterial(0, MaterialInstance);
 }
 
-UMaterialInstanceDynamic* UGltf1Importer::LoadMaterial(const tinygltf::Material& Material, USceneComponent* Parent)
+UMaterialInstanceDynamic* UGltf1Importer::GetMaterial(const tinygltf::Material& Material, USceneComponent* Parent)
 {
-	UMaterialInstanceDynamic* MaterialInstance = NULL;
+	// Blocks materials have no parameters, every material using the same
+	// shader shares its instance.
 	tinygltf::Technique& Technique = Scene.techniques[Material.technique];
+	FString Shader = UTF8_TO_TCHAR(Technique.extras.Get("gvrss").Get<std::string>().c_str());
 
-	const std::string& gvrss = Technique.extras.Get("gvrss").Get<std::string>();
-	if(gvrss == "https://vr.google.com/shaders/w/gvrss/paper.json")
+	UMaterialInstanceDynamic** MaterialInstance = MaterialInstances.Find(Shader);
+	if(MaterialInstance != NULL)
 	{
-		MaterialInstance = UMaterialInstanceDynamic::Create(PaperMaterial, Parent);
+		return *MaterialInstance;
 	}
-	else if(gvrss == "https://vr.google.com/shaders/w/gvrss/glass.json")
+	return MaterialInstances.Add(Shader, LoadMaterial(Shader, Parent->GetOwner()));
+}
+
+UMaterialInstanceDynamic* UGltf1Importer::LoadMaterial(const FString& Shader, UObject* Outer)
+{
+	FPolyMaterialKey Key;
+	if(Shader == TEXT("https://vr.google.com/shaders/w/gvrss/paper.json"))
 	{
-		MaterialInstance = UMaterialInstanceDynamic::Create(GlassMaterial, Parent);
+		Key.Parent = PaperMaterial;
 	}
-	else if(gvrss == "https://vr.google.com/shaders/w/gvrss/gem.json")
+	else if(Shader == TEXT("https://vr.google.com/shaders/w/gvrss/glass.json"))
+	{
+		Key.Parent = GlassMaterial;
+	}
+	else if(Shader == TEXT("https://vr.google.com/shaders/w/gvrss/gem.json"))
 	{
 		// TODO(pmanzi) Gem = Glass until Gem is properly implemented.
-		MaterialInstance = UMaterialInstanceDynamic::Create(GlassMaterial, Parent);
+		Key.Parent = GlassMaterial;
+	}
+	else
+	{
+		return NULL;
 	}
 
-	return MaterialInstance;
+	if(Options.ShareMaterials)
+	{
+		UPolyMaterialCache* MaterialCache = UPolyToolkit::GetPolyToolkitInstance()->GetMaterialCache();
+		UMaterialInstanceDynamic* MaterialInstance = MaterialCache->Find(Key);
+		return MaterialInstance != NULL ? MaterialInstance : MaterialCache->Create(Key);
+	}
+	return UMaterialInstanceDynamic::Create(Key.Parent, Outer);
 }
 
 
-	template<typename T, typename U>
-TArray<T> UGltf1Importer::LoadAttribute(const tinygltf::Accessor& Accessor)
+FGltfAccessorView UGltf1Importer::GetAccessorView(const tinygltf::Accessor& Accessor)
 {
-	TArray<T> Elements;
-
-	int ElementSize = 0;
-	int BytesPerComponent = CalculateBytesPerComponent(Accessor.componentType);
-	int NumComponents = CalculateNumComponents(Accessor.type);
-	ElementSize = BytesPerComponent * NumComponents;
-
-	tinygltf::BufferView& BufferView = Scene.bufferViews[Accessor.bufferView];
-	tinygltf::Buffer& Buffer = Scene.buffers[BufferView.buffer];
-
-	U* Values = new U[NumComponents];
-	for (unsigned int i = 0; i < Accessor.count; i++)
+	FGltfAccessorView View;
+	View.Count = Accessor.count;
+	View.Stride = Accessor.byteStride;
+	View.NumComponents = CalculateNumComponents(Accessor.type);
+	View.ComponentType = static_cast<EGltfComponentType>(Accessor.componentType);
+
+	// Called from parallel tasks, the maps must not be modified.
+	auto BufferViewIt = Scene.bufferViews.find(Accessor.bufferView);
+	auto BufferIt = BufferViewIt != Scene.bufferViews.end() ? Scene.buffers.find(BufferViewIt->second.buffer) : Scene.buffers.end();
+	if(BufferIt == Scene.buffers.end())
 	{
-		memset(Values, 0, sizeof(U) * NumComponents);
-		int Stride = Accessor.byteStride ? Accessor.byteStride : ElementSize;
-
-		for (int j = 0; j < NumComponents; j++)
-		{
-			char Component[4];
-			memset(Component, 0, 4);
-			memcpy(Component, Buffer.data.data() + Accessor.byteOffset + BufferView.byteOffset + Stride * i + BytesPerComponent * j, BytesPerComponent);
-			Values[j] = *(reinterpret_cast<U*>(Component));
-		}
-		T* Element;
-		if (std::is_same<T, FVector>::value)
-		{
-			FVector Vector(-Values[2] *100, Values[0]*100, Values[1]*100);
-			Element = reinterpret_cast<T*> (&Vector);
-			Elements.Add(*Element);
-		}
-		else if(std::is_same<T, FVector2D>::value)
-		{
-			FVector2D Vector2D(Values[0], Values[1]);
-			Element = reinterpret_cast<T*> (&Vector2D);
-			Elements.Add(*Element);
-		}
-		else if(std::is_same<T, int32>::value)
-		{
-			int32 Val = Values[0];
-			Element = reinterpret_cast<T*> (&Val);
-			Elements.Add(*Element);
-		}
-		else if(std::is_same<T, FColor>::value)
-		{
-			FLinearColor LinearColor(Values[0], Values[1], Values[2], Values[3]);
-			FColor Color = LinearColor.ToFColor(false);
-			Element = reinterpret_cast<T*> (&Color);
-			Elements.Add(*Element);
-		}
+		UE_LOG(LogTemp, Warning, TEXT("Accessor has no buffer"));
+		View.Count = 0;
+		return View;
 	}
-	delete[] Values;
-	return Elements;
-}
-
-template TArray<int32> UGltf1Importer::LoadAttribute<int32, int32>(const tinygltf::Accessor& Accessor);
-template TArray<FVector> UGltf1Importer::LoadAttribute<FVector, float>(const tinygltf::Accessor& Accessor);
-template TArray<FVector2D> UGltf1Importer::LoadAttribute<FVector2D, float>(const tinygltf::Accessor& Accessor);
-template TArray<FColor> UGltf1Importer::LoadAttribute<FColor, float>(const tinygltf::Accessor& Accessor);
+	const tinygltf::BufferView& BufferView = BufferViewIt->second;
+	const tinygltf::Buffer& Buffer = BufferIt->second;
 
-int UGltf1Importer::CalculateBytesPerComponent(int ComponentType)
-{
-	switch(ComponentType)
+	int64 Offset = static_cast<int64>(BufferView.byteOffset) + Accessor.byteOffset;
+	if(Offset + View.GetByteLength() > static_cast<int64>(Buffer.data.size()))
 	{
-		case TINYGLTF_COMPONENT_TYPE_BYTE:
-		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
-			return 1;
-		case TINYGLTF_COMPONENT_TYPE_SHORT:
-		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-			return 2;
-		case TINYGLTF_COMPONENT_TYPE_INT:
-		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
-		case TINYGLTF_COMPONENT_TYPE_FLOAT:
-			return 4;
-		default:
-			return 0;
+		UE_LOG(LogTemp, Warning, TEXT("Accessor is out of the bounds of its buffer"));
+		View.Count = 0;
+		return View;
 	}
+	View.Data = Buffer.data.data() + Offset;
+	return View;
 }
 
 int UGltf1Importer::CalculateNumComponents(int Type)
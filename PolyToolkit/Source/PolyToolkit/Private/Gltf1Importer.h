@@ -17,40 +17,109 @@
 #include "CoreMinimal.h"
 #include "Engine.h"
 #include "GameFramework/Actor.h"
+#include "GltfAccessor.h"
+#include "GltfMeshSection.h"
 #include "IImageWrapper.h"
 #include "IImageWrapperModule.h"
 #include "PolyAsset.h"
+#include "PolyFileIO.h"
+#include "PolyImportOptions.h"
 #include "tiny_gltf_loader.h"
 
 #include "Gltf1Importer.generated.h"
 
+class UProceduralMeshComponent;
+
+/**
+ * Imports a glTF model in steps. BeginImport runs on the game thread, then
+ * ParseModel or ParseModelFromMemory do all the heavy lifting and can run on
+ * any thread. Back on the game thread BeginCreateModel and CreateComponents
+ * build the actor, over as many frames as needed.
+ */
 UCLASS()
 	class UGltf1Importer : public UObject
 {
 	GENERATED_UCLASS_BODY()
 public:
+	/** Prepares the importer for a new model. Must be called on the game thread. */
+	void BeginImport(const FPolyImportOptions& ImportOptions);
+
+	/**
+	 * Parses a glTF file from the game's content folder and decodes its
+	 * geometry. Creates no UObject, can run on any thread.
+	 */
+	bool ParseModel(const FPolyFormat& Format, const FString& AssetName);
+
+	/**
+	 * Same as ParseModel from downloaded files kept in memory. Resources maps
+	 * the relative path of every file of Format to its contents.
+	 */
+	bool ParseModelFromMemory(const FPolyFormat& Format, const TMap<FString, FPolySharedContent>& Resources);
+
+	/**
+	 * Starts generating the meshes and materials of the parsed model on the
+	 * game thread. The result is attached to PolyActor as the root component.
+	 */
+	void BeginCreateModel(AActor* PolyActor);
+
 	/**
-	 * Imports a glTF file generating meshes and materials. The result is
-	 * attached to PolyActor as the root component.
+	 * Creates components until EndTime, in FPlatformTime::Seconds. Returns
+	 * true once the whole model is created.
 	 */
-	void ImportModel(const FPolyFormat& Format, const FString& AssetName, AActor* PolyActor);
+	bool CreateComponents(double EndTime);
+
+	/** Fraction of the components of the model created so far. */
+	float GetCreationProgress() const;
 
 private:
-	void LoadScene(const std::vector<std::string>& SceneNodes, AActor* PolyActor);
-	void LoadNode(const tinygltf::Node& Node, USceneComponent* Parent);
-	void LoadMesh(const tinygltf::Mesh& Mesh, USceneComponent* Parent);
-	void LoadPrimitive(const tinygltf::Primitive& Primitive, USceneComponent* Parent);
-	UMaterialInstanceDynamic* LoadMaterial(const tinygltf::Material& Material, USceneComponent* Parent);
+	// A node or primitive component left to create.
+	struct FPendingComponent
+	{
+		// Position of the parent in PendingComponents, INDEX_NONE for the root.
+		int32 Parent = INDEX_NONE;
+
+		// Set for node components.
+		const tinygltf::Node* Node = NULL;
+
+		// Set for primitive components.
+		const tinygltf::Primitive* Primitive = NULL;
+		const FGltfMeshSection* Section = NULL;
+	};
+
+	void DecodeScene();
+	void DecodePrimitive(const tinygltf::Primitive& Primitive, FGltfMeshSection& Section);
+	void AddPendingNode(const tinygltf::Node& Node, int32 Parent);
+	USceneComponent* LoadNode(const tinygltf::Node& Node, USceneComponent* Parent);
+	void LoadPrimitive(const tinygltf::Primitive& Primitive, const FGltfMeshSection& Section, USceneComponent* Parent);
+	UMaterialInstanceDynamic* GetMaterial(const tinygltf::Material& Material, USceneComponent* Parent);
+	UMaterialInstanceDynamic* LoadMaterial(const FString& Shader, UObject* Outer);
 
-	int CalculateBytesPerComponent(int ComponentType);
 	int CalculateNumComponents(int Type);
 
-	template<typename T, typename U>
-	TArray<T> LoadAttribute(const tinygltf::Accessor& accessor);
+	/** Locates the elements of Accessor in its buffer, to be decoded with LoadGltfAccessor. */
+	FGltfAccessorView GetAccessorView(const tinygltf::Accessor& Accessor);
 
 	// tinygltfloader Scene.
 	tinygltf::Scene Scene;
 
+	FPolyImportOptions Options;
+
+	// Decoded primitives by glTF mesh name and primitive index.
+	TMap<FString, TArray<FGltfMeshSection>> MeshSections;
+
+	// Components left to create, the next one and the ones created so far.
+	TArray<FPendingComponent> PendingComponents;
+	int32 NextPendingComponent;
+	UPROPERTY()
+	TArray<USceneComponent*> CreatedComponents;
+
+	UPROPERTY()
+	UProceduralMeshComponent* RootMesh;
+
+	// Material instances of this import by gvrss shader.
+	UPROPERTY()
+	TMap<FString, UMaterialInstanceDynamic*> MaterialInstances;
+
 	// Full path to asset folder.
 	FString AssetPath;
 
@@ -19,7 +19,19 @@
 #include "ProceduralMeshComponent.h"
 #include "IImageWrapperModule.h"
 #include "IImageWrapper.h"
-#include <cstring>
+#include "PolyImageDecodePool.h"
+#include "PolyMaterialCache.h"
+#include "PolyTextureCache.h"
+#include "PolyToolkit.h"
+#include "PolyToolkitStats.h"
+#include "Async/ParallelFor.h"
+#include "Serialization/BufferReader.h"
+#include "Serialization/MemoryWriter.h"
+
+// Identifies cooked models. Bump the version whenever what is cooked
+// changes, older files are then imported from the original ones again.
+#define GLTF2_COOKED_MAGIC 0x32475043 // "CPG2"
+#define GLTF2_COOKED_VERSION 5
 
 UGltf2Importer::UGltf2Importer(const class FObjectInitializer& PCIP) : Super(PCIP)
 {
@@ -33,10 +45,22 @@ UGltf2Importer::UGltf2Importer(const class FObjectInitializer& PCIP) : Super(PCI
 	{
 		PbrMaterialTranslucent = PbrMatTranslucentFinder.Object;
 	}
+	NextPendingComponent = 0;
+	ImageDecodePool = NULL;
 }
 
 
-void UGltf2Importer::ImportModel(const FPolyFormat& File, const FString& AssetName, AActor* PolyActor)
+void UGltf2Importer::BeginImport(const FPolyImportOptions& ImportOptions, FPolyImageDecodePool* InImageDecodePool)
+{
+	check(IsInGameThread());
+	Options = ImportOptions;
+	ImageDecodePool = InImageDecodePool;
+	MaterialInstances.Empty();
+	Textures.Empty();
+	TextureCache = UPolyToolkit::GetPolyToolkitInstance()->GetTextureCache();
+}
+
+bool UGltf2Importer::ParseModel(const FPolyFormat& File, const FString& AssetName)
 {
 #if PLATFORM_ANDROID
 	FString BasePath = "/sdcard/UE4Game/HelloPolyToolkit/HelloPolyToolkit/Content/";
@@ -47,130 +71,744 @@ void UGltf2Importer::ImportModel(const FPolyFormat& File, const FString& AssetNa
 	FString RootFilePath = FPaths::Combine(AssetPath, File.root.relativePath);
 	Asset = gltf2::load(TCHAR_TO_ANSI(*RootFilePath));
 
+	DecodeScene();
+	return true;
+}
+
+bool UGltf2Importer::ParseModelFromMemory(const FPolyFormat& File, const TMap<FString, FPolySharedContent>& Resources)
+{
+	const FPolySharedContent* Root = Resources.Find(File.root.relativePath);
+	if(Root == NULL)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Root file %s was not downloaded"), *File.root.relativePath);
+		return false;
+	}
+
+	// Buffers and images point into Resources, which outlives the import.
+	Asset = gltf2::load(reinterpret_cast<const char*>((*Root)->GetData()), (*Root)->Num(),
+		[&Resources](const std::string& Uri, const char*& Data, size_t& Size)
+		{
+			const FPolySharedContent* Resource = Resources.Find(UTF8_TO_TCHAR(Uri.c_str()));
+			if(Resource == NULL)
+			{
+				return false;
+			}
+			Data = reinterpret_cast<const char*>((*Resource)->GetData());
+			Size = (*Resource)->Num();
+			return true;
+		});
+
+	DecodeScene();
+	return true;
+}
+
+// Fits the pixels of Image in the size budget of the import and builds their
+// mips, then compresses them if asked to and if their size allows. Images
+// are only used as base color, they are all sRGB.
+static void PrepareDecodedImage(FGltf2DecodedImage& Image, const FPolyImportOptions& Options)
+{
+	if(Image.BGRA.Num() == 0)
+	{
+		return;
+	}
+
+	FPolyMipGenerator::Fit(Image.BGRA, Image.Width, Image.Height, Options.MaxTextureSize);
+	if(Options.GenerateMips)
+	{
+		FPolyMipGenerator::Generate(Image.BGRA.GetData(), Image.Width, Image.Height, Image.Mips);
+	}
+
+	if(Options.CompressTextures && FPolyTextureCompressor::Compress(Image.BGRA.GetData(), Image.Width, Image.Height, Image.Mips, Image.Compressed))
+	{
+		Image.BGRA.Empty();
+		Image.Mips.Empty();
+	}
+}
+
+void UGltf2Importer::CookModel(TArray<uint8>& Cooked)
+{
+	// Images skipped because a texture already has them are decoded too,
+	// the texture may be gone by the next import.
+	TArray<int32> SkippedImages;
+	for(int32 i = 0; i < DecodedImages.Num(); i++)
+	{
+		if(DecodedImages[i].bCached)
+		{
+			DecodeImage(i, false);
+			PrepareDecodedImage(DecodedImages[i], Options);
+			SkippedImages.Add(i);
+		}
+	}
+
+	FMemoryWriter Writer(Cooked);
+	SerializeCookedModel(Writer);
+
+	for(int32 i : SkippedImages)
+	{
+		DecodedImages[i].BGRA.Empty();
+		DecodedImages[i].Mips.Empty();
+		DecodedImages[i].Compressed.Mips.Empty();
+		DecodedImages[i].bCached = true;
+	}
+}
+
+bool UGltf2Importer::LoadCookedModel(const uint8* Cooked, int64 Size)
+{
+	// Nothing is parsed, the streams are copied out in bulk.
+	Asset = gltf2::Asset();
+	MeshSections.Empty();
+	MergedSections.Empty();
+	MaterialToMergedSection.Empty();
+	DecodedImages.Empty();
+
+	FBufferReader Reader(const_cast<uint8*>(Cooked), Size, false);
+	if(!SerializeCookedModel(Reader))
+	{
+		return false;
+	}
+
+	for(int32 i = 0; i < MergedSections.Num(); i++)
+	{
+		MaterialToMergedSection.Add(MergedSections[i].Material, i);
+	}
+	for(FGltf2DecodedImage& Image : DecodedImages)
+	{
+		Image.bCached = Image.HasPixels() && TextureCache->Contains(Image.Hash);
+	}
+	return true;
+}
+
+// Reads or writes the number of elements of a container. A count read
+// back is checked against the bytes left, so a bad file cannot make us
+// allocate much.
+static int32 SerializeNum(FArchive& Ar, int32 Num)
+{
+	Ar << Num;
+	if(Ar.IsLoading() && (Num < 0 || Num > Ar.TotalSize() - Ar.Tell()))
+	{
+		Ar.ArIsError = true;
+		return 0;
+	}
+	return Num;
+}
+
+template<typename T>
+static void SerializeVector(FArchive& Ar, std::vector<T>& Vector)
+{
+	Vector.resize(SerializeNum(Ar, Vector.size()));
+	for(T& Element : Vector)
+	{
+		Ar << Element;
+	}
+}
+
+static void SerializeSection(FArchive& Ar, FGltfMeshSection& Section)
+{
+	Section.Vertices.BulkSerialize(Ar);
+	Section.Triangles.BulkSerialize(Ar);
+	Section.Normals.BulkSerialize(Ar);
+	Section.TextCoords.BulkSerialize(Ar);
+	Section.VertexColors.BulkSerialize(Ar);
+}
+
+static void SerializeMips(FArchive& Ar, TArray<FPolyMip>& Mips)
+{
+	Mips.SetNum(SerializeNum(Ar, Mips.Num()));
+	for(FPolyMip& Mip : Mips)
+	{
+		Ar << Mip.Width << Mip.Height;
+		Mip.Data.BulkSerialize(Ar);
+	}
+}
+
+bool UGltf2Importer::SerializeCookedModel(FArchive& Ar)
+{
+	uint32 Magic = GLTF2_COOKED_MAGIC;
+	int32 Version = GLTF2_COOKED_VERSION;
+	bool bMerged = Options.MergeMeshes;
+	bool bCompressed = Options.CompressTextures;
+	bool bMips = Options.GenerateMips;
+	int32 MaxTextureSize = Options.MaxTextureSize;
+	Ar << Magic << Version << bMerged << bCompressed << bMips << MaxTextureSize;
+	if(Magic != GLTF2_COOKED_MAGIC || Version != GLTF2_COOKED_VERSION || bMerged != Options.MergeMeshes || bCompressed != Options.CompressTextures
+		|| bMips != Options.GenerateMips || MaxTextureSize != Options.MaxTextureSize)
+	{
+		return false;
+	}
+
+	// Only what creating the components needs is kept of the glTF asset.
+	Ar << Asset.scene;
+	Asset.scenes.resize(SerializeNum(Ar, Asset.scenes.size()));
+	for(gltf2::Scene& Scene : Asset.scenes)
+	{
+		SerializeVector(Ar, Scene.nodes);
+	}
+
+	Asset.nodes.resize(SerializeNum(Ar, Asset.nodes.size()));
+	for(gltf2::Node& Node : Asset.nodes)
+	{
+		// The node transform is resolved once and stored as its matrix.
+		FMatrix Matrix = Ar.IsSaving() ? GetNodeMatrix(Node) : FMatrix::Identity;
+		Ar << Matrix << Node.mesh;
+		if(Ar.IsLoading())
+		{
+			FMemory::Memcpy(Node.matrix, Matrix.M, sizeof(Node.matrix));
+		}
+		SerializeVector(Ar, Node.children);
+	}
+
+	Asset.meshes.resize(SerializeNum(Ar, Asset.meshes.size()));
+	for(gltf2::Mesh& Mesh : Asset.meshes)
+	{
+		Mesh.primitives.resize(SerializeNum(Ar, Mesh.primitives.size()));
+		for(gltf2::Primitive& Primitive : Mesh.primitives)
+		{
+			uint8 Mode = static_cast<uint8>(Primitive.mode);
+			Ar << Mode << Primitive.material;
+			Primitive.mode = static_cast<gltf2::Primitive::Mode>(Mode);
+		}
+	}
+
+	Asset.materials.resize(SerializeNum(Ar, Asset.materials.size()));
+	for(gltf2::Material& Material : Asset.materials)
+	{
+		uint8 AlphaMode = static_cast<uint8>(Material.alphaMode);
+		Ar << AlphaMode << Material.doubleSided;
+		Ar << Material.pbr.metallicFactor << Material.pbr.roughnessFactor << Material.pbr.baseColorTexture.index;
+		for(float& Factor : Material.pbr.baseColorFactor)
+		{
+			Ar << Factor;
+		}
+		Material.alphaMode = static_cast<gltf2::Material::AlphaMode>(AlphaMode);
+	}
+
+	Asset.textures.resize(SerializeNum(Ar, Asset.textures.size()));
+	for(gltf2::Texture& Texture : Asset.textures)
+	{
+		Ar << Texture.source;
+	}
+
+	// Decoded pixels and geometry, in bulk.
+	DecodedImages.SetNum(SerializeNum(Ar, DecodedImages.Num()));
+	for(FGltf2DecodedImage& Image : DecodedImages)
+	{
+		Ar << Image.Hash << Image.Width << Image.Height << Image.BGRA;
+		SerializeMips(Ar, Image.Mips);
+
+		uint8 PixelFormat = static_cast<uint8>(Image.Compressed.PixelFormat);
+		Ar << PixelFormat;
+		Image.Compressed.PixelFormat = static_cast<EPixelFormat>(PixelFormat);
+		SerializeMips(Ar, Image.Compressed.Mips);
+	}
+
+	MeshSections.SetNum(SerializeNum(Ar, MeshSections.Num()));
+	for(TArray<FGltfMeshSection>& Sections : MeshSections)
+	{
+		Sections.SetNum(SerializeNum(Ar, Sections.Num()));
+		for(FGltfMeshSection& Section : Sections)
+		{
+			SerializeSection(Ar, Section);
+		}
+	}
+
+	MergedSections.SetNum(SerializeNum(Ar, MergedSections.Num()));
+	for(FGltf2MergedSection& Section : MergedSections)
+	{
+		Ar << Section.Material;
+		SerializeSection(Ar, Section);
+	}
+
+	return !Ar.IsError();
+}
+
+void UGltf2Importer::DecodeScene()
+{
 	if(Asset.metadata.version != "2.0")
 	{
 		UE_LOG(LogTemp, Warning, TEXT("Version %s not supported"), UTF8_TO_TCHAR(Asset.metadata.version.c_str()));
 	}
 
-	if(Asset.scene != -1)
+	// Decode every primitive on its own task, each into its own section.
+	MeshSections.Empty();
+	MeshSections.SetNum(Asset.meshes.size());
+	TArray<TPair<int32, int32>> Primitives;
+	for(int i = 0; i < Asset.meshes.size(); i++)
 	{
-		LoadScene(Asset.scenes[Asset.scene], PolyActor);
+		const gltf2::Mesh& Mesh = Asset.meshes[i];
+		MeshSections[i].SetNum(Mesh.primitives.size());
+		for(int j = 0; j < Mesh.primitives.size(); j++)
+		{
+			Primitives.Add(TPair<int32, int32>(i, j));
+		}
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_PolyDecodePrimitives);
+		ParallelFor(Primitives.Num(), [this, &Primitives](int32 Index)
+		{
+			const TPair<int32, int32>& Primitive = Primitives[Index];
+			DecodePrimitive(Asset.meshes[Primitive.Key].primitives[Primitive.Value], MeshSections[Primitive.Key][Primitive.Value]);
+		}, CVarPolyParallelDecode.GetValueOnAnyThread() == 0);
+	}
+
+	MergedSections.Empty();
+	MaterialToMergedSection.Empty();
+	if(Options.MergeMeshes)
+	{
+		// Bake the whole scene into the sections of the root component.
+		if(Asset.scene != -1)
+		{
+			const gltf2::Scene& Scene = Asset.scenes[Asset.scene];
+			for(int i = 0; i < Scene.nodes.size(); i++)
+			{
+				MergeNode(Asset.nodes[Scene.nodes[i]], FMatrix::Identity);
+			}
+		}
+		MeshSections.Empty();
+	}
+
+	// Decode the images used by materials, the textures themselves can only
+	// be created on the game thread.
+	DecodedImages.Empty();
+	DecodedImages.SetNum(Asset.images.size());
+	TArray<int32> UsedImages;
+	for(const gltf2::Material& Material : Asset.materials)
+	{
+		if(Material.pbr.baseColorTexture.index != -1)
+		{
+			UsedImages.AddUnique(Asset.textures[Material.pbr.baseColorTexture.index].source);
+		}
+	}
+	ParallelFor(UsedImages.Num(), [this, &UsedImages](int32 Index)
+	{
+		DecodeImage(UsedImages[Index], true);
+		PrepareDecodedImage(DecodedImages[UsedImages[Index]], Options);
+	});
+}
+
+// Accessor of the attribute Name of Primitive, -1 if it does not have it.
+static int32 FindAttribute(const gltf2::Primitive& Primitive, const char* Name)
+{
+	auto it = Primitive.attributes.find(Name);
+	return it != Primitive.attributes.end() ? it->second : -1;
+}
+
+void UGltf2Importer::DecodePrimitive(const gltf2::Primitive& Primitive, FGltfMeshSection& Section)
+{
+	if(Primitive.mode != gltf2::Primitive::Mode::Triangles)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Mode is not triangles, cannot be loaded."));
+		return;
+	}
+
+	enum EAttribute
+	{
+		Indices,
+		Positions,
+		Normals,
+		TextCoords,
+		NumAttributes
+	};
+	const int32 Accessors[NumAttributes] =
+	{
+		Primitive.indices,
+		FindAttribute(Primitive, "POSITION"),
+		FindAttribute(Primitive, "NORMAL"),
+		FindAttribute(Primitive, "TEXCOORD_0")
+	};
+
+	// Every attribute has its own array, large primitives decode them in parallel.
+	const bool bSingleThread = CVarPolyParallelDecode.GetValueOnAnyThread() == 0 || Accessors[Positions] == -1 || Asset.accessors[Accessors[Positions]].count < GltfParallelAttributesMinVertices;
+	ParallelFor(NumAttributes, [this, &Accessors, &Section](int32 Attribute)
+	{
+		if(Accessors[Attribute] == -1)
+		{
+			return;
+		}
+
+		FGltfAccessorView View = GetAccessorView(Asset.accessors[Accessors[Attribute]]);
+		switch(Attribute)
+		{
+			case Indices:
+				Section.Triangles = LoadGltfAccessor<int32>(View);
+				break;
+			case Positions:
+				Section.Vertices = LoadGltfAccessor<FVector>(View);
+				break;
+			case Normals:
+				Section.Normals = LoadGltfAccessor<FVector>(View);
+				break;
+			case TextCoords:
+				Section.TextCoords = LoadGltfAccessor<FVector2D>(View);
+				break;
+		}
+	}, bSingleThread);
+}
+
+bool UGltf2Importer::ResolveCachedTextures()
+{
+	check(IsInGameThread());
+
+	MissingImages.Empty();
+	for(int32 i = 0; i < DecodedImages.Num(); i++)
+	{
+		FGltf2DecodedImage& Image = DecodedImages[i];
+		if(!Image.bCached)
+		{
+			continue;
+		}
+
+		UTexture2D* CachedTexture = TextureCache->Find(Image.Hash);
+		if(CachedTexture != NULL)
+		{
+			// Referenced by Textures, it can no longer be collected. The
+			// pixels of a cooked model are not needed anymore.
+			Textures.Add(i, CachedTexture);
+			Image.BGRA.Empty();
+			Image.Mips.Empty();
+			Image.Compressed.Mips.Empty();
+			continue;
+		}
+
+		// Collected since the image was skipped.
+		Image.bCached = false;
+		if(!Image.HasPixels())
+		{
+			MissingImages.Add(i);
+		}
+	}
+	return MissingImages.Num() == 0;
+}
+
+void UGltf2Importer::DecodeMissingImages()
+{
+	ParallelFor(MissingImages.Num(), [this](int32 Index)
+	{
+		DecodeImage(MissingImages[Index], false);
+		PrepareDecodedImage(DecodedImages[MissingImages[Index]], Options);
+	});
+	MissingImages.Empty();
+}
+
+void UGltf2Importer::BeginCreateModel(AActor* PolyActor)
+{
+	check(IsInGameThread());
+
+	// Create root component.
+	RootMesh = NewObject<UProceduralMeshComponent>(PolyActor);
+	PolyActor->SetRootComponent(RootMesh);
+	RootMesh->RegisterComponent();
+
+	// List everything to create up front, parents before their children, so
+	// CreateComponents can stop and resume anywhere.
+	PendingComponents.Empty();
+	NextPendingComponent = 0;
+	if(Options.MergeMeshes)
+	{
+		for(int32 i = 0; i < MergedSections.Num(); i++)
+		{
+			PendingComponents.Add(FPendingComponent(FPendingComponent::MergedSection, INDEX_NONE, i));
+		}
+	}
+	else if(Asset.scene != -1)
+	{
+		const gltf2::Scene& Scene = Asset.scenes[Asset.scene];
+		for(int i = 0; i < Scene.nodes.size(); i++)
+		{
+			AddPendingNode(Scene.nodes[i], INDEX_NONE);
+		}
 	}
 	else
 	{
 		UE_LOG(LogTemp, Warning, TEXT("No default scene"));
 	}
+
+	CreatedComponents.Empty();
+	CreatedComponents.SetNumZeroed(PendingComponents.Num());
 }
 
-void UGltf2Importer::LoadScene(const gltf2::Scene& Scene, AActor* PolyActor)
+void UGltf2Importer::AddPendingNode(int32 NodeIndex, int32 Parent)
 {
-	// Create root component.
-	UProceduralMeshComponent* Mesh = NewObject<UProceduralMeshComponent>(PolyActor);
-	PolyActor->SetRootComponent(Mesh);
-	Mesh->RegisterComponent();
-	// Iterate through Nodes.
-	for(int i = 0; i < Scene.nodes.size(); i++)
+	const gltf2::Node& Node = Asset.nodes[NodeIndex];
+	int32 NodeComponent = PendingComponents.Add(FPendingComponent(FPendingComponent::Node, Parent, NodeIndex));
+
+	if(Node.mesh != -1)
+	{
+		const gltf2::Mesh& Mesh = Asset.meshes[Node.mesh];
+		for(int i = 0; i < Mesh.primitives.size(); i++)
+		{
+			PendingComponents.Add(FPendingComponent(FPendingComponent::Primitive, NodeComponent, Node.mesh, i));
+		}
+	}
+
+	for(int i = 0; i < Node.children.size(); i++)
 	{
-		LoadNode(Asset.nodes[Scene.nodes[i]], Mesh);
+		AddPendingNode(Node.children[i], NodeComponent);
 	}
 }
 
-void UGltf2Importer::LoadNode(const gltf2::Node& Node, USceneComponent* Parent)
+bool UGltf2Importer::CreateComponents(double EndTime)
 {
-	// Create Node component.
-	UProceduralMeshComponent* NodeComponent = NewObject<UProceduralMeshComponent>(Parent);
-	NodeComponent->SetupAttachment(Parent);
-	NodeComponent->RegisterComponent();
-	// Apply transform from TRS.
+	check(IsInGameThread());
 
+	// At least one component per call, so the import always moves forward.
+	while(NextPendingComponent < PendingComponents.Num())
+	{
+		CreatePendingComponent(NextPendingComponent++);
+		if(FPlatformTime::Seconds() >= EndTime)
+		{
+			break;
+		}
+	}
+
+	if(NextPendingComponent < PendingComponents.Num())
+	{
+		return false;
+	}
+
+	// The geometry and pixels now live in the components and textures.
+	MeshSections.Empty();
+	DecodedImages.Empty();
+	MergedSections.Empty();
+	MaterialToMergedSection.Empty();
+	PendingComponents.Empty();
+	CreatedComponents.Empty();
+	NextPendingComponent = 0;
+	return true;
+}
+
+float UGltf2Importer::GetCreationProgress() const
+{
+	return PendingComponents.Num() > 0 ? static_cast<float>(NextPendingComponent) / PendingComponents.Num() : 1.0f;
+}
+
+void UGltf2Importer::CreatePendingComponent(int32 Index)
+{
+	const FPendingComponent& Pending = PendingComponents[Index];
+	USceneComponent* Parent = Pending.Parent != INDEX_NONE ? CreatedComponents[Pending.Parent] : RootMesh;
+	switch(Pending.Type)
+	{
+		case FPendingComponent::Node:
+			CreatedComponents[Index] = LoadNode(Asset.nodes[Pending.Index], Parent);
+			break;
+		case FPendingComponent::Primitive:
+			LoadPrimitive(Asset.meshes[Pending.Index].primitives[Pending.Primitive], MeshSections[Pending.Index][Pending.Primitive], Parent);
+			break;
+		case FPendingComponent::MergedSection:
+			CreateMergedSection(Pending.Index, RootMesh);
+			break;
+	}
+}
+
+FMatrix UGltf2Importer::GetNodeMatrix(const gltf2::Node& Node)
+{
+	// glTF matrices are column-major with column vectors, Unreal uses row
+	// vectors so the transposed matrix is the array read row by row.
+	FMatrix Matrix;
+	FMemory::Memcpy(Matrix.M, Node.matrix, sizeof(Node.matrix));
+	if(!Matrix.Equals(FMatrix::Identity, 0.0f))
+	{
+		return Matrix;
+	}
+
+	// Apply transform from TRS.
 	FVector Scale(Node.scale[0], Node.scale[1], Node.scale[2]);
 	FQuat Rotation(Node.rotation[0], Node.rotation[1], Node.rotation[2], Node.rotation[3]);
 	FVector Translation(Node.translation[0], Node.translation[1], Node.translation[2]);
-	FTransform Transform(Rotation, Translation, Scale);
-	NodeComponent->SetRelativeTransform(Transform);
+	return FTransform(Rotation, Translation, Scale).ToMatrixWithScale();
+}
+
+USceneComponent* UGltf2Importer::LoadNode(const gltf2::Node& Node, USceneComponent* Parent)
+{
+	// Create Node component, its mesh and children are created after it.
+	UProceduralMeshComponent* NodeComponent = NewObject<UProceduralMeshComponent>(Parent);
+	NodeComponent->SetupAttachment(Parent);
+	NodeComponent->RegisterComponent();
+	NodeComponent->SetRelativeTransform(FTransform(GetNodeMatrix(Node)));
+	return NodeComponent;
+}
+
+void UGltf2Importer::LoadPrimitive(const gltf2::Primitive& Primitive, const FGltfMeshSection& Section, USceneComponent* Parent)
+{
+	if(Primitive.mode != gltf2::Primitive::Mode::Triangles)
+	{
+		return;
+	}
+
+	//Create procedural mesh component for this primitive
+	UProceduralMeshComponent* Mesh = NewObject<UProceduralMeshComponent>(Parent);
+	Mesh->CreateMeshSection(0, Section.Vertices, Section.Triangles, Section.Normals, Section.TextCoords, Section.VertexColors, TArray<FProcMeshTangent>(), false);
+	Mesh->SetupAttachment(Parent);
+	Mesh->RegisterComponent();
+
+	UMaterialInstanceDynamic* MaterialInstance = NULL;
+	if (Primitive.material != -1)
+	{
+		MaterialInstance = GetMaterial(Primitive.material, Mesh);
+	}
+
+	Mesh->SetMaterial(0, MaterialInstance);
+}
+
+void UGltf2Importer::MergeNode(const gltf2::Node& Node, const FMatrix& ParentTransform)
+{
+	// Same composition as attached components: the node is relative to its parent.
+	FMatrix Transform = GetNodeMatrix(Node) * ParentTransform;
 
-	// Load mesh of component.
 	if(Node.mesh != -1)
 	{
-		LoadMesh(Asset.meshes[Node.mesh], NodeComponent);
+		const gltf2::Mesh& Mesh = Asset.meshes[Node.mesh];
+		for(int i = 0; i < Mesh.primitives.size(); i++)
+		{
+			MergePrimitive(Mesh.primitives[i], MeshSections[Node.mesh][i], Transform);
+		}
 	}
 
-	// Load children of this Node.
-	for (int i = 0; i < Node.children.size(); i++)
+	for(int i = 0; i < Node.children.size(); i++)
 	{
-		LoadNode(Asset.nodes[Node.children[i]], NodeComponent);
+		MergeNode(Asset.nodes[Node.children[i]], Transform);
 	}
 }
 
-void UGltf2Importer::LoadMesh(const gltf2::Mesh& Mesh, USceneComponent* Parent)
+// Appends Count elements of Source to Target. Sections only keep an
+// attribute if one of their primitives has it, the others are zero filled
+// so every attribute array matches the vertices.
+template<typename T>
+static void AppendVertexAttribute(TArray<T>& Target, int32 BaseVertex, const TArray<T>& Source, int32 Count)
 {
-	// Load all the primitives of this mesh.
-	for(int i = 0; i < Mesh.primitives.size(); i++)
+	if(Source.Num() != Count)
+	{
+		if(Target.Num() > 0)
+		{
+			Target.AddZeroed(Count);
+		}
+		return;
+	}
+
+	if(Target.Num() == 0 && BaseVertex > 0)
 	{
-		LoadPrimitive(Mesh.primitives[i], Parent);
+		Target.AddZeroed(BaseVertex);
 	}
+	Target.Append(Source);
 }
 
-void UGltf2Importer::LoadPrimitive(const gltf2::Primitive& Primitive, USceneComponent* Parent)
+void UGltf2Importer::MergePrimitive(const gltf2::Primitive& Primitive, const FGltfMeshSection& Decoded, const FMatrix& Transform)
 {
-	if(Primitive.mode != gltf2::Primitive::Mode::Triangles)
+	if(Primitive.mode != gltf2::Primitive::Mode::Triangles || Decoded.Vertices.Num() == 0)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Mode is not triangles, cannot be loaded."));
 		return;
 	}
 
-	TArray<int32> Triangles;
-	if(Primitive.indices != -1)
+	int32* SectionIndex = MaterialToMergedSection.Find(Primitive.material);
+	if(SectionIndex == NULL)
 	{
-		Triangles = LoadAttribute<int32,int32>(Asset.accessors[Primitive.indices]);
+		SectionIndex = &MaterialToMergedSection.Add(Primitive.material, MergedSections.AddDefaulted());
+		MergedSections[*SectionIndex].Material = Primitive.material;
 	}
+	FGltf2MergedSection& Section = MergedSections[*SectionIndex];
+	const int32 BaseVertex = Section.Vertices.Num();
+	const int32 NumVertices = Decoded.Vertices.Num();
 
-	TArray<FVector> Vertices;
-	auto it = Primitive.attributes.find("POSITION");
-	if(it!= Primitive.attributes.end())
+	// Bake the node transform, normals use the inverse transpose so they stay
+	// perpendicular under non-uniform scale. Instanced meshes are decoded
+	// once and baked for every node using them.
+	Section.Vertices.Reserve(BaseVertex + NumVertices);
+	for(const FVector& Vertex : Decoded.Vertices)
 	{
-		Vertices = LoadAttribute<FVector, float>(Asset.accessors[it->second]);
+		Section.Vertices.Add(Transform.TransformPosition(Vertex));
 	}
 
 	TArray<FVector> Normals;
-	it = Primitive.attributes.find("NORMAL");
-	if(it!= Primitive.attributes.end())
+	if(Decoded.Normals.Num() > 0)
 	{
-		Normals = LoadAttribute<FVector, float>(Asset.accessors[it->second]);
+		FMatrix NormalTransform = Transform.Inverse().GetTransposed();
+		Normals.Reserve(Decoded.Normals.Num());
+		for(const FVector& Normal : Decoded.Normals)
+		{
+			Normals.Add(NormalTransform.TransformVector(Normal).GetSafeNormal());
+		}
 	}
+	AppendVertexAttribute(Section.Normals, BaseVertex, Normals, NumVertices);
+	AppendVertexAttribute(Section.TextCoords, BaseVertex, Decoded.TextCoords, NumVertices);
 
-	TArray<FVector2D> TextCoords;
-	it = Primitive.attributes.find("TEXCOORD_0");
-	if(it!= Primitive.attributes.end())
+	// Mirroring transforms flip the winding of the triangles.
+	const bool bFlipWinding = Transform.Determinant() < 0.0f;
+	const TArray<int32>* Triangles = &Decoded.Triangles;
+	TArray<int32> UnindexedTriangles;
+	if(Primitive.indices == -1)
 	{
-		TextCoords = LoadAttribute<FVector2D, float>(Asset.accessors[it->second]);
+		// Not indexed, every 3 vertices are a triangle.
+		UnindexedTriangles.SetNumUninitialized(NumVertices - NumVertices % 3);
+		for(int32 i = 0; i < UnindexedTriangles.Num(); i++)
+		{
+			UnindexedTriangles[i] = i;
+		}
+		Triangles = &UnindexedTriangles;
 	}
 
-	//Create procedural mesh component for this primitive
-	UProceduralMeshComponent* Mesh = NewObject<UProceduralMeshComponent>(Parent);
-	Mesh->CreateMeshSection(0, Vertices, Triangles, Normals, TextCoords, TArray<FColor>(), TArray<FProcMeshTangent>(), false);
-	Mesh->SetupAttachment(Parent);
-	Mesh->RegisterComponent();
+	Section.Triangles.Reserve(Section.Triangles.Num() + Triangles->Num());
+	for(int32 i = 0; i + 2 < Triangles->Num(); i += 3)
+	{
+		Section.Triangles.Add(BaseVertex + (*Triangles)[i]);
+		Section.Triangles.Add(BaseVertex + (*Triangles)[bFlipWinding ? i + 2 : i + 1]);
+		Section.Triangles.Add(BaseVertex + (*Triangles)[bFlipWinding ? i + 1 : i + 2]);
+	}
+}
+
+void UGltf2Importer::CreateMergedSection(int32 SectionIndex, UProceduralMeshComponent* Mesh)
+{
+	FGltf2MergedSection& Section = MergedSections[SectionIndex];
+	Mesh->CreateMeshSection(SectionIndex, Section.Vertices, Section.Triangles, Section.Normals, Section.TextCoords, Section.VertexColors, TArray<FProcMeshTangent>(), false);
 
 	UMaterialInstanceDynamic* MaterialInstance = NULL;
-	if (Primitive.material != -1)
+	if(Section.Material != -1)
 	{
-		MaterialInstance = LoadMaterial(Asset.materials[Primitive.material], Mesh);
+		MaterialInstance = GetMaterial(Section.Material, Mesh);
 	}
+	Mesh->SetMaterial(SectionIndex, MaterialInstance);
+}
 
-	Mesh->SetMaterial(0, MaterialInstance);
+UMaterialInstanceDynamic* UGltf2Importer::GetMaterial(int32 MaterialIndex, USceneComponent* Parent)
+{
+	// Every primitive using a material shares its instance.
+	UMaterialInstanceDynamic** MaterialInstance = MaterialInstances.Find(MaterialIndex);
+	if(MaterialInstance != NULL)
+	{
+		return *MaterialInstance;
+	}
+	return MaterialInstances.Add(MaterialIndex, LoadMaterial(Asset.materials[MaterialIndex], Parent->GetOwner()));
 }
 
-UMaterialInstanceDynamic* UGltf2Importer::LoadMaterial(const gltf2::Material& Material, USceneComponent* Parent)
+UMaterialInstanceDynamic* UGltf2Importer::LoadMaterial(const gltf2::Material& Material, UObject* Outer)
 {
+	UTexture2D* BaseColorTexture = NULL;
+	if (Material.pbr.baseColorTexture.index != -1)
+	{
+		BaseColorTexture = GetTexture(Asset.textures[Material.pbr.baseColorTexture.index].source);
+	}
+
+	FPolyMaterialKey Key;
+	Key.Parent = Material.alphaMode == gltf2::Material::AlphaMode::Blend ? PbrMaterialTranslucent : PbrMaterial;
+	Key.Parameters.Add(Material.pbr.metallicFactor);
+	Key.Parameters.Add(Material.pbr.roughnessFactor);
+	Key.Parameters.Append(Material.pbr.baseColorFactor, ARRAY_COUNT(Material.pbr.baseColorFactor));
+	Key.Textures.Add(BaseColorTexture);
+	Key.TwoSided = Material.doubleSided;
+
 	UMaterialInstanceDynamic* MaterialInstance;
-	if(Material.alphaMode == gltf2::Material::AlphaMode::Blend)
+	if(Options.ShareMaterials)
 	{
-		MaterialInstance = UMaterialInstanceDynamic::Create(PbrMaterialTranslucent, Parent);
+		UPolyMaterialCache* MaterialCache = UPolyToolkit::GetPolyToolkitInstance()->GetMaterialCache();
+		MaterialInstance = MaterialCache->Find(Key);
+		if(MaterialInstance != NULL)
+		{
+			return MaterialInstance;
+		}
+		MaterialInstance = MaterialCache->Create(Key);
 	}
 	else
 	{
-		MaterialInstance = UMaterialInstanceDynamic::Create(PbrMaterial, Parent);
+		MaterialInstance = UMaterialInstanceDynamic::Create(Key.Parent, Outer);
 	}
 
 	MaterialInstance->SetScalarParameterValue(FName(TEXT("MetallicFactor")), Material.pbr.metallicFactor);
@@ -181,104 +819,219 @@ UMaterialInstanceDynamic* UGltf2Importer::LoadMaterial(const gltf2::Material& Ma
 
 	if (Material.pbr.baseColorTexture.index != -1)
 	{
-		gltf2::Texture& Texture = Asset.textures[Material.pbr.baseColorTexture.index];
-		gltf2::Image& BaseColorImage = Asset.images[Texture.source];
-		EImageFormat ImageFormat = EImageFormat::Invalid;
-		if (BaseColorImage.mimeType == "image/png")
+		MaterialInstance->SetTextureParameterValue(FName(TEXT("BaseColorTexture")), BaseColorTexture);
+	}
+	return MaterialInstance;
+}
+
+UTexture2D* UGltf2Importer::GetTexture(int32 ImageIndex)
+{
+	// Every material using an image shares its texture.
+	UTexture2D** Texture = Textures.Find(ImageIndex);
+	if(Texture != NULL)
+	{
+		return *Texture;
+	}
+	return Textures.Add(ImageIndex, CreateTexture(ImageIndex));
+}
+
+// Copies Data to a mip of a texture being created, whatever its size was.
+static void SetMipData(FTexture2DMipMap& Mip, const TArray<uint8>& Data)
+{
+	Mip.BulkData.Lock(LOCK_READ_WRITE);
+	void* MipData = Mip.BulkData.Realloc(Data.Num());
+	FMemory::Memcpy(MipData, Data.GetData(), Data.Num());
+	Mip.BulkData.Unlock();
+}
+
+// CreateTransient only makes the first mip, the others are appended.
+static void AddMip(UTexture2D* Texture, const FPolyMip& Level)
+{
+	FTexture2DMipMap* Mip = new FTexture2DMipMap();
+	Texture->PlatformData->Mips.Add(Mip);
+	Mip->SizeX = Level.Width;
+	Mip->SizeY = Level.Height;
+	SetMipData(*Mip, Level.Data);
+}
+
+UTexture2D* UGltf2Importer::CreateTexture(int32 ImageIndex)
+{
+	// Textures of skipped images were found by ResolveCachedTextures, the
+	// others all have their pixels.
+	FGltf2DecodedImage& Image = DecodedImages[ImageIndex];
+	UTexture2D* LoadedT2D = NULL;
+	if(Image.Compressed.Mips.Num() > 0)
+	{
+		const TArray<FPolyMip>& Mips = Image.Compressed.Mips;
+		LoadedT2D = UTexture2D::CreateTransient(Mips[0].Width, Mips[0].Height, Image.Compressed.PixelFormat);
+		if(LoadedT2D != NULL)
 		{
-			ImageFormat = EImageFormat::PNG;
+			SetMipData(LoadedT2D->PlatformData->Mips[0], Mips[0].Data);
+			for(int32 i = 1; i < Mips.Num(); i++)
+			{
+				AddMip(LoadedT2D, Mips[i]);
+			}
 		}
-		else if (BaseColorImage.mimeType == "image/jpeg")
+	}
+	else if(Image.BGRA.Num() > 0)
+	{
+		LoadedT2D = UTexture2D::CreateTransient(Image.Width, Image.Height, PF_B8G8R8A8);
+		if(LoadedT2D != NULL)
 		{
-			ImageFormat = EImageFormat::JPEG;
+			SetMipData(LoadedT2D->PlatformData->Mips[0], Image.BGRA);
+			for(const FPolyMip& Mip : Image.Mips)
+			{
+				AddMip(LoadedT2D, Mip);
+			}
 		}
+	}
+
+	Image.BGRA.Empty();
+	Image.Mips.Empty();
+	Image.Compressed.Mips.Empty();
+	if(LoadedT2D == NULL)
+	{
+		return NULL;
+	}
+
+	LoadedT2D->UpdateResource();
+	TextureCache->Add(Image.Hash, LoadedT2D);
+	return LoadedT2D;
+}
+
+void UGltf2Importer::DecodeImage(int32 ImageIndex, bool bSkipCachedImage)
+{
+	const gltf2::Image& Image = Asset.images[ImageIndex];
+
+	// Images of downloaded files may have been decoded while the other files
+	// downloaded. The pool knows them by path relative to the asset, the
+	// uris of a model parsed from disk are full paths.
+	if(bSkipCachedImage && ImageDecodePool != NULL && Image.bufferView == -1 && !Image.uri.empty())
+	{
+		FString RelativePath = UTF8_TO_TCHAR(Image.uri.c_str());
+		if(AssetPath.IsEmpty() || FPaths::MakePathRelativeTo(RelativePath, *(AssetPath + TEXT("/"))))
+		{
+			if(ImageDecodePool->Take(RelativePath, DecodedImages[ImageIndex]))
+			{
+				return;
+			}
+		}
+	}
+
+	EImageFormat ImageFormat = GetImageFormat(UTF8_TO_TCHAR(Image.mimeType.c_str()));
+
+	// Files are only read for the decode, embedded images are decoded in place.
+	TArray<uint8> FileData;
+	const uint8* RawFileData = NULL;
+	int32 RawFileSize = 0;
+	if(Image.bufferView != -1)
+	{
+		// Image embedded in a buffer, e.g. in a .glb.
+		const gltf2::BufferView& BufferView = Asset.bufferViews[Image.bufferView];
+		const gltf2::Buffer& Buffer = Asset.buffers[BufferView.buffer];
+		RawFileData = reinterpret_cast<const uint8*>(Buffer.data + BufferView.byteOffset);
+		RawFileSize = BufferView.byteLength;
+	}
+	else if(Image.data != nullptr)
+	{
+		// Image embedded in a data uri or provided by the resolver when
+		// importing from memory.
+		RawFileData = reinterpret_cast<const uint8*>(Image.data);
+		RawFileSize = Image.byteLength;
+	}
+	else
+	{
 #if PLATFORM_ANDROID
 		FString TexturePath;
 		const FRegexPattern Pattern(TEXT("^\\/sdcard\\/UE4Game\\/HelloPolyToolkit(\\/HelloPolyToolkit.*)$"));
-		FRegexMatcher Matcher(Pattern, UTF8_TO_TCHAR(BaseColorImage.uri.c_str()));
+		FRegexMatcher Matcher(Pattern, UTF8_TO_TCHAR(Image.uri.c_str()));
 		if(Matcher.FindNext())
 		{
 			TexturePath = Matcher.GetCaptureGroup(1);
 		}
 #else
-		FString TexturePath = BaseColorImage.uri.c_str();
+		FString TexturePath = Image.uri.c_str();
 #endif
-		UTexture2D* BaseColorTexture = LoadTexture2DFromFile(TexturePath, ImageFormat);
-		MaterialInstance->SetTextureParameterValue(FName(TEXT("BaseColorTexture")), BaseColorTexture);
+		if(!FFileHelper::LoadFileToArray(FileData, *TexturePath))
+		{
+			return;
+		}
+		RawFileData = FileData.GetData();
+		RawFileSize = FileData.Num();
 	}
-	return MaterialInstance;
+
+	DecodeImageData(RawFileData, RawFileSize, ImageFormat, Options, bSkipCachedImage ? TextureCache : NULL, DecodedImages[ImageIndex]);
 }
 
-template<typename T, typename U>
-TArray<T> UGltf2Importer::LoadAttribute(const gltf2::Accessor& Accessor)
+EImageFormat UGltf2Importer::GetImageFormat(const FString& MimeType)
 {
-	TArray<T> Elements;
-
-	int ElementSize = 0;
-	int BytesPerComponent = CalculateBytesPerComponent(Accessor.componentType);
-	int NumComponents = CalculateNumComponents(Accessor.type);
-	ElementSize = BytesPerComponent * NumComponents;
+	if(MimeType == TEXT("image/png"))
+	{
+		return EImageFormat::PNG;
+	}
+	if(MimeType == TEXT("image/jpeg"))
+	{
+		return EImageFormat::JPEG;
+	}
+	return EImageFormat::Invalid;
+}
 
-	gltf2::BufferView& BufferView = Asset.bufferViews[Accessor.bufferView];
-	gltf2::Buffer& Buffer = Asset.buffers[BufferView.buffer];
+bool UGltf2Importer::DecodeImageData(const uint8* RawFileData, int32 RawFileSize, EImageFormat ImageFormat, const FPolyImportOptions& ImportOptions, const UPolyTextureCache* TextureCache, FGltf2DecodedImage& DecodedImage)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PolyDecodeImages);
 
-	U* Values = new U[NumComponents];
-	for (unsigned int i = 0; i < Accessor.count; i++)
+	// Skip the decode if another import already has the same image loaded,
+	// into the same kind of texture.
+	DecodedImage.Hash = UPolyTextureCache::HashImage(RawFileData, RawFileSize, ImportOptions);
+	DecodedImage.bCached = TextureCache != NULL && TextureCache->Contains(DecodedImage.Hash);
+	if(DecodedImage.bCached)
 	{
-		memset(Values, 0, sizeof(U) * NumComponents);
-		int Stride = BufferView.byteStride ? BufferView.byteStride : ElementSize;
+		return true;
+	}
 
-		for (int j = 0; j < NumComponents; j++)
-		{
-			char Component[4];
-			memset(Component, 0, 4);
-			memcpy(Component, Buffer.data + Accessor.byteOffset + BufferView.byteOffset + Stride * i + BytesPerComponent * j, BytesPerComponent);
-			Values[j] = *(reinterpret_cast<U*>(Component));
-		}
-		T* Element;
-		if (std::is_same<T, FVector>::value)
-		{
-			FVector Vector(-Values[2] *100, Values[0]*100, Values[1]*100);
-			Element = reinterpret_cast<T*> (&Vector);
-			Elements.Add(*Element);
-		}
-		else if(std::is_same<T, FVector2D>::value)
-		{
-			FVector2D Vector2D(Values[0], Values[1]);
-			Element = reinterpret_cast<T*> (&Vector2D);
-			Elements.Add(*Element);
-		}
-		else if(std::is_same<T, int32>::value)
+	// The module is loaded on the game thread before the import starts.
+	IImageWrapperModule& ImageWrapperModule = FModuleManager::GetModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+	TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(ImageFormat);
+
+	if (ImageWrapper.IsValid() && ImageWrapper->SetCompressed(RawFileData, RawFileSize))
+	{
+		const TArray<uint8>* UncompressedBGRA = NULL;
+		if (ImageWrapper->GetRaw(ERGBFormat::BGRA, 8, UncompressedBGRA))
 		{
-			int32 Val = Values[0];
-			Element = reinterpret_cast<T*> (&Val);
-			Elements.Add(*Element);
+			DecodedImage.Width = ImageWrapper->GetWidth();
+			DecodedImage.Height = ImageWrapper->GetHeight();
+			DecodedImage.BGRA = *UncompressedBGRA;
+			return true;
 		}
 	}
-	delete[] Values;
-	return Elements;
+	return false;
 }
 
-template TArray<int32> UGltf2Importer::LoadAttribute<int32, int32>(const gltf2::Accessor& Accessor);
-template TArray<FVector> UGltf2Importer::LoadAttribute<FVector, float>(const gltf2::Accessor& Accessor);
-template TArray<FVector2D> UGltf2Importer::LoadAttribute<FVector2D, float>(const gltf2::Accessor& Accessor);
-
-int UGltf2Importer::CalculateBytesPerComponent(gltf2::Accessor::ComponentType ComponentType)
+FGltfAccessorView UGltf2Importer::GetAccessorView(const gltf2::Accessor& Accessor)
 {
-	switch(ComponentType)
+	FGltfAccessorView View;
+	View.Count = Accessor.count;
+	View.NumComponents = CalculateNumComponents(Accessor.type);
+	View.ComponentType = static_cast<EGltfComponentType>(Accessor.componentType);
+	View.bNormalized = Accessor.normalized;
+
+	// An accessor without buffer view is all zeros.
+	if(Accessor.bufferView != -1)
 	{
-		case gltf2::Accessor::ComponentType::Byte:
-		case gltf2::Accessor::ComponentType::UnsignedByte:
-			return 1;
-		case gltf2::Accessor::ComponentType::Short:
-		case gltf2::Accessor::ComponentType::UnsignedShort:
-			return 2;
-		case gltf2::Accessor::ComponentType::UnsignedInt:
-		case gltf2::Accessor::ComponentType::Float:
-			return 4;
-		default:
-			return 0;
+		const gltf2::BufferView& BufferView = Asset.bufferViews[Accessor.bufferView];
+		const gltf2::Buffer& Buffer = Asset.buffers[BufferView.buffer];
+		View.Stride = BufferView.byteStride;
+
+		int64 Offset = static_cast<int64>(BufferView.byteOffset) + Accessor.byteOffset;
+		if(Offset + View.GetByteLength() > Buffer.byteLength)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Accessor is out of the bounds of its buffer"));
+			View.Count = 0;
+			return View;
+		}
+		View.Data = reinterpret_cast<const uint8*>(Buffer.data) + Offset;
 	}
+	return View;
 }
 
 int UGltf2Importer::CalculateNumComponents(gltf2::Accessor::Type Type)
@@ -302,41 +1055,3 @@ int UGltf2Importer::CalculateNumComponents(gltf2::Accessor::Type Type)
 			return 0;
 	}
 }
-
-UTexture2D* UGltf2Importer::LoadTexture2DFromFile(const FString& FullFilePath, EImageFormat ImageFormat)
-{
-	UTexture2D* LoadedT2D = NULL;
-
-	IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
-	TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(ImageFormat);
-
-	// Load File
-	TArray<uint8> RawFileData;
-	if (!FFileHelper::LoadFileToArray(RawFileData, * FullFilePath))
-	{
-		return NULL;
-	}
-
-	// Create Texture
-	if (ImageWrapper.IsValid() && ImageWrapper->SetCompressed(RawFileData.GetData(), RawFileData.Num()))
-	{
-		const TArray<uint8>* UncompressedBGRA = NULL;
-		if (ImageWrapper->GetRaw(ERGBFormat::BGRA, 8, UncompressedBGRA))
-		{
-			LoadedT2D = UTexture2D::CreateTransient(ImageWrapper->GetWidth(), ImageWrapper->GetHeight(), PF_B8G8R8A8);
-			if (!LoadedT2D)
-			{
-				return NULL;
-			}
-
-			// Copy Data
-			void* TextureData = LoadedT2D->PlatformData->Mips[0].BulkData.Lock(LOCK_READ_WRITE);
-			FMemory::Memcpy(TextureData, UncompressedBGRA->GetData(), UncompressedBGRA->Num());
-			LoadedT2D->PlatformData->Mips[0].BulkData.Unlock();
-			LoadedT2D->UpdateResource();
-		}
-	}
-
-	return LoadedT2D;
-}
-
@@ -17,9 +17,16 @@
 #include "CoreMinimal.h"
 #include "Engine.h"
 #include "GameFramework/Actor.h"
+#include "GltfAccessor.h"
+#include "GltfMeshSection.h"
 #include "IImageWrapper.h"
 #include "IImageWrapperModule.h"
+#include "Misc/SecureHash.h"
 #include "PolyAsset.h"
+#include "PolyFileIO.h"
+#include "PolyImportOptions.h"
+#include "PolyMipGenerator.h"
+#include "PolyTextureCompressor.h"
 #include "gltf2/glTF2.hpp"
 
 #if PLATFORM_WINDOWS
@@ -28,34 +35,233 @@
 
 #include "Gltf2Importer.generated.h"
 
+class FPolyImageDecodePool;
+class UPolyTextureCache;
+class UProceduralMeshComponent;
+
+/**
+ * Geometry of all the primitives sharing a material, baked in the space of
+ * the root component.
+ */
+struct FGltf2MergedSection : public FGltfMeshSection
+{
+	int32 Material = -1;
+};
+
+/**
+ * Pixels of an image decoded off the game thread, waiting for its texture.
+ */
+struct FGltf2DecodedImage
+{
+	// Hash of the compressed image and import options, see UPolyTextureCache.
+	FSHAHash Hash;
+
+	// True if the image was not decoded because a texture of a previous
+	// import already has it.
+	bool bCached = false;
+
+	int32 Width = 0;
+	int32 Height = 0;
+	TArray<uint8> BGRA;
+
+	// Smaller levels of BGRA, largest first, see FPolyMipGenerator.
+	TArray<FPolyMip> Mips;
+
+	// Replaces BGRA and Mips when the import compresses textures.
+	FPolyCompressedTexture Compressed;
+
+	bool HasPixels() const { return BGRA.Num() > 0 || Compressed.Mips.Num() > 0; }
+};
+
+/**
+ * Imports a glTF2 model in steps. BeginImport runs on the game thread, then
+ * ParseModel or ParseModelFromMemory do all the heavy lifting and can run on
+ * any thread, or LoadCookedModel reads their result back from a previous
+ * import. Back on the game thread ResolveCachedTextures, BeginCreateModel
+ * and CreateComponents build the actor, over as many frames as needed.
+ */
 UCLASS()
 class UGltf2Importer : public UObject
 {
 	GENERATED_UCLASS_BODY()
 public:
 	/**
-	 * Imports a glTF2 file generating meshes and materials. The result is
-	 * attached to PolyActor as the root component.
+	 * Prepares the importer for a new model. Must be called on the game
+	 * thread. Images of the model found in ImageDecodePool are taken from
+	 * there instead of being decoded by the importer.
 	 */
-	void ImportModel(const FPolyFormat& Format, const FString& AssetName, AActor* PolyActor);
+	void BeginImport(const FPolyImportOptions& ImportOptions, FPolyImageDecodePool* InImageDecodePool = NULL);
+
+	/**
+	 * Parses a glTF2 file from the game's content folder and decodes its
+	 * geometry and images. Creates no UObject, can run on any thread.
+	 */
+	bool ParseModel(const FPolyFormat& Format, const FString& AssetName);
+
+	/**
+	 * Same as ParseModel from downloaded files kept in memory. Resources maps
+	 * the relative path of every file of Format to its contents, it must not
+	 * change until the model is created.
+	 */
+	bool ParseModelFromMemory(const FPolyFormat& Format, const TMap<FString, FPolySharedContent>& Resources);
+
+	/**
+	 * Writes the parsed model to Cooked, in a binary form LoadCookedModel
+	 * reads back without parsing any JSON or decoding anything. Must be
+	 * called right after ParseModel, on the same thread.
+	 */
+	void CookModel(TArray<uint8>& Cooked);
+
+	/**
+	 * Same as ParseModel from a model cooked by a previous import, read back
+	 * from the disk cache. Fails if it was cooked with other options or by
+	 * another version of the importer. Cooked can be a file mapped in
+	 * memory, the streams are copied straight from it.
+	 */
+	bool LoadCookedModel(const uint8* Cooked, int64 Size);
+
+	/**
+	 * Takes the textures of previous imports whose images were skipped, they
+	 * are then kept alive until the model is created. Must be called on the
+	 * game thread before BeginCreateModel. Returns false if some of them
+	 * were collected since, DecodeMissingImages must then decode their
+	 * images first.
+	 */
+	bool ResolveCachedTextures();
+
+	/**
+	 * Decodes the images of the textures ResolveCachedTextures did not find.
+	 * Creates no UObject, can run on any thread.
+	 */
+	void DecodeMissingImages();
+
+	/**
+	 * Starts generating the meshes and materials of the parsed model on the
+	 * game thread. The result is attached to PolyActor as the root component.
+	 */
+	void BeginCreateModel(AActor* PolyActor);
+
+	/**
+	 * Creates components until EndTime, in FPlatformTime::Seconds. Returns
+	 * true once the whole model is created.
+	 */
+	bool CreateComponents(double EndTime);
+
+	/** Fraction of the components of the model created so far. */
+	float GetCreationProgress() const;
+
+	/** Format of the images of the MIME type MimeType, Invalid if not supported. */
+	static EImageFormat GetImageFormat(const FString& MimeType);
+
+	/**
+	 * Decodes an image to BGRA pixels, on any thread. The decode is skipped if
+	 * a texture of TextureCache was decoded from the same image with the same
+	 * ImportOptions, unless it is NULL. Returns false if the image could not be
+	 * decoded.
+	 */
+	static bool DecodeImageData(const uint8* RawFileData, int32 RawFileSize, EImageFormat ImageFormat, const FPolyImportOptions& ImportOptions, const UPolyTextureCache* TextureCache, FGltf2DecodedImage& DecodedImage);
 
 private:
-	void LoadScene(const gltf2::Scene& Scene, AActor* PolyActor);
-	void LoadNode(const gltf2::Node& Node, USceneComponent* Parent);
-	void LoadMesh(const gltf2::Mesh& Mesh, USceneComponent* Parent);
-	void LoadPrimitive(const gltf2::Primitive& Primitive, USceneComponent* Parent);
-	UMaterialInstanceDynamic* LoadMaterial(const gltf2::Material& Material, USceneComponent* Parent);
+	// A component left to create, or a section of the root component in a
+	// merged import.
+	struct FPendingComponent
+	{
+		enum EType
+		{
+			Node,
+			Primitive,
+			MergedSection
+		};
+
+		FPendingComponent(EType InType, int32 InParent, int32 InIndex, int32 InPrimitive = INDEX_NONE)
+			: Type(InType), Parent(InParent), Index(InIndex), Primitive(InPrimitive)
+		{
+		}
+
+		EType Type;
+
+		// Position of the parent in PendingComponents, INDEX_NONE for the root.
+		int32 Parent;
+
+		// Node, mesh or merged section index depending on Type.
+		int32 Index;
+
+		// Primitive of the mesh for primitive components.
+		int32 Primitive;
+	};
+
+	// Worker side.
+	void DecodeScene();
+	void DecodePrimitive(const gltf2::Primitive& Primitive, FGltfMeshSection& Section);
+	void DecodeImage(int32 ImageIndex, bool bSkipCachedImage);
+	FMatrix GetNodeMatrix(const gltf2::Node& Node);
+
+	// Merged import, see FPolyImportOptions::MergeMeshes.
+	void MergeNode(const gltf2::Node& Node, const FMatrix& ParentTransform);
+	void MergePrimitive(const gltf2::Primitive& Primitive, const FGltfMeshSection& Decoded, const FMatrix& Transform);
+
+	// Game thread side.
+	void AddPendingNode(int32 NodeIndex, int32 Parent);
+	void CreatePendingComponent(int32 Index);
+	USceneComponent* LoadNode(const gltf2::Node& Node, USceneComponent* Parent);
+	void LoadPrimitive(const gltf2::Primitive& Primitive, const FGltfMeshSection& Section, USceneComponent* Parent);
+	void CreateMergedSection(int32 SectionIndex, UProceduralMeshComponent* Mesh);
+	UMaterialInstanceDynamic* GetMaterial(int32 MaterialIndex, USceneComponent* Parent);
+	UMaterialInstanceDynamic* LoadMaterial(const gltf2::Material& Material, UObject* Outer);
+	UTexture2D* GetTexture(int32 ImageIndex);
+	UTexture2D* CreateTexture(int32 ImageIndex);
+
+	// Cooked models, reads or writes depending on Ar.
+	bool SerializeCookedModel(FArchive& Ar);
 
-	int CalculateBytesPerComponent(gltf2::Accessor::ComponentType ComponentType);
 	int CalculateNumComponents(gltf2::Accessor::Type Type);
-	UTexture2D* LoadTexture2DFromFile(const FString& FullFilePath, EImageFormat ImageFormat);
 
-	template<typename T, typename U>
-	TArray<T> LoadAttribute(const gltf2::Accessor& accessor);
+	/** Locates the elements of Accessor in its buffer, to be decoded with LoadGltfAccessor. */
+	FGltfAccessorView GetAccessorView(const gltf2::Accessor& Accessor);
 
 	// gltf2-loader Asset
 	gltf2::Asset Asset;
 
+	FPolyImportOptions Options;
+
+	// Decoded primitives by glTF mesh and primitive index, in a merged import
+	// only until they are baked into MergedSections.
+	TArray<TArray<FGltfMeshSection>> MeshSections;
+
+	// Decoded images by glTF image index, only the ones used by materials.
+	TArray<FGltf2DecodedImage> DecodedImages;
+
+	// Skipped images whose texture was collected before the model was created.
+	TArray<int32> MissingImages;
+
+	// Material instances of this import by glTF material index.
+	UPROPERTY()
+	TMap<int32, UMaterialInstanceDynamic*> MaterialInstances;
+
+	// Textures of this import by glTF image index.
+	UPROPERTY()
+	TMap<int32, UTexture2D*> Textures;
+
+	// Components left to create, the next one and the ones created so far.
+	TArray<FPendingComponent> PendingComponents;
+	int32 NextPendingComponent;
+	UPROPERTY()
+	TArray<USceneComponent*> CreatedComponents;
+
+	UPROPERTY()
+	UProceduralMeshComponent* RootMesh;
+
+	// Sections of a merged import and the material they were created for.
+	TArray<FGltf2MergedSection> MergedSections;
+	TMap<int32, int32> MaterialToMergedSection;
+
+	// Textures decoded by previous imports.
+	UPROPERTY()
+	UPolyTextureCache* TextureCache;
+
+	// Images decoded while the files of the model downloaded, may be NULL.
+	FPolyImageDecodePool* ImageDecodePool;
+
 	// Full path to asset folder.
 	FString AssetPath;
 
@@ -0,0 +1,359 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <type_traits>
+
+/**
+ * Component types of an accessor, the values are the GL enums used by both
+ * glTF 1 and glTF 2.
+ */
+enum class EGltfComponentType : uint16
+{
+	Byte = 5120,
+	UnsignedByte = 5121,
+	Short = 5122,
+	UnsignedShort = 5123,
+	Int = 5124,
+	UnsignedInt = 5125,
+	Float = 5126
+};
+
+/** Size in bytes of a component, 0 for unknown types. */
+inline int32 GetGltfComponentSize(EGltfComponentType ComponentType)
+{
+	switch(ComponentType)
+	{
+		case EGltfComponentType::Byte:
+		case EGltfComponentType::UnsignedByte:
+			return 1;
+		case EGltfComponentType::Short:
+		case EGltfComponentType::UnsignedShort:
+			return 2;
+		case EGltfComponentType::Int:
+		case EGltfComponentType::UnsignedInt:
+		case EGltfComponentType::Float:
+			return 4;
+		default:
+			return 0;
+	}
+}
+
+/**
+ * Where the elements of an accessor are in memory and how they are stored,
+ * whatever the glTF version they come from.
+ */
+struct FGltfAccessorView
+{
+	/** First element, all the elements are zeros when NULL. */
+	const uint8* Data = NULL;
+
+	int32 Count = 0;
+
+	/** Bytes between the start of two elements, 0 if they are tightly packed. */
+	int32 Stride = 0;
+
+	int32 NumComponents = 0;
+	EGltfComponentType ComponentType = EGltfComponentType::Float;
+
+	/** Integer components are mapped to [0, 1] or [-1, 1]. */
+	bool bNormalized = false;
+
+	int32 GetElementSize() const
+	{
+		return GetGltfComponentSize(ComponentType) * NumComponents;
+	}
+
+	int32 GetStride() const
+	{
+		return Stride ? Stride : GetElementSize();
+	}
+
+	/** Number of bytes spanned by all the elements. */
+	int64 GetByteLength() const
+	{
+		return Count > 0 ? static_cast<int64>(GetStride()) * (Count - 1) + GetElementSize() : 0;
+	}
+};
+
+namespace GltfAccessorImpl
+{
+	template<typename TComponent>
+	FORCEINLINE TComponent ReadComponent(const uint8* Data)
+	{
+		// Buffer views are not guaranteed to be aligned in memory.
+		TComponent Value;
+		FMemory::Memcpy(&Value, Data, sizeof(TComponent));
+		return Value;
+	}
+
+	/** Converts a component to float, with the glTF normalization rules when bNormalized. */
+	template<typename TComponent, bool bNormalized>
+	struct TComponentToFloat
+	{
+		static FORCEINLINE float Convert(TComponent Value) { return static_cast<float>(Value); }
+	};
+
+	template<>
+	struct TComponentToFloat<int8, true>
+	{
+		static FORCEINLINE float Convert(int8 Value) { return FMath::Max(Value / 127.0f, -1.0f); }
+	};
+
+	template<>
+	struct TComponentToFloat<uint8, true>
+	{
+		static FORCEINLINE float Convert(uint8 Value) { return Value / 255.0f; }
+	};
+
+	template<>
+	struct TComponentToFloat<int16, true>
+	{
+		static FORCEINLINE float Convert(int16 Value) { return FMath::Max(Value / 32767.0f, -1.0f); }
+	};
+
+	template<>
+	struct TComponentToFloat<uint16, true>
+	{
+		static FORCEINLINE float Convert(uint16 Value) { return Value / 65535.0f; }
+	};
+
+	/**
+	 * Reads the first N components of an element as floats. Components the
+	 * accessor does not have are set to Default.
+	 */
+	template<typename TComponent, bool bNormalized, int32 N>
+	FORCEINLINE void ReadFloats(const uint8* Element, int32 NumComponents, float Default, float (&Values)[N])
+	{
+		for(int32 j = 0; j < N; j++)
+		{
+			Values[j] = j < NumComponents
+				? TComponentToFloat<TComponent, bNormalized>::Convert(ReadComponent<TComponent>(Element + j * sizeof(TComponent)))
+				: Default;
+		}
+	}
+
+	/**
+	 * Swizzles and scales tightly packed float vectors from glTF to Unreal
+	 * coordinates, four at a time. Returns the number of vectors decoded.
+	 */
+	inline int32 DecodePackedVectors(const float* Src, int32 Count, FVector* Out)
+	{
+		// glTF is right handed Y up in meters, Unreal is left handed Z up in
+		// centimeters: (x, y, z) becomes (-z, x, y) * 100. Four tightly packed
+		// vectors are 3 registers, swizzled and scaled without leaving them.
+		const VectorRegister Scale0 = MakeVectorRegister(-100.0f, 100.0f, 100.0f, -100.0f);
+		const VectorRegister Scale1 = MakeVectorRegister(100.0f, 100.0f, -100.0f, 100.0f);
+		const VectorRegister Scale2 = MakeVectorRegister(100.0f, -100.0f, 100.0f, 100.0f);
+		float* Dst = reinterpret_cast<float*>(Out);
+
+		int32 i = 0;
+		for(; i + 4 <= Count; i += 4, Src += 12, Dst += 12)
+		{
+			// A = x0 y0 z0 x1, B = y1 z1 x2 y2, C = z2 x3 y3 z3
+			VectorRegister A = VectorLoad(Src);
+			VectorRegister B = VectorLoad(Src + 4);
+			VectorRegister C = VectorLoad(Src + 8);
+
+			// z0 x0 y0 z1
+			VectorRegister Y0Z1 = VectorShuffle(A, B, 1, 1, 1, 1);
+			VectorRegister Out0 = VectorShuffle(A, Y0Z1, 2, 0, 0, 2);
+			// x1 y1 z2 x2
+			VectorRegister X1Y1 = VectorShuffle(A, B, 3, 3, 0, 0);
+			VectorRegister Z2X2 = VectorShuffle(C, B, 0, 0, 2, 2);
+			VectorRegister Out1 = VectorShuffle(X1Y1, Z2X2, 0, 2, 0, 2);
+			// y2 z3 x3 y3
+			VectorRegister Y2Z3 = VectorShuffle(B, C, 3, 3, 3, 3);
+			VectorRegister Out2 = VectorShuffle(Y2Z3, C, 0, 2, 1, 2);
+
+			VectorStore(VectorMultiply(Out0, Scale0), Dst);
+			VectorStore(VectorMultiply(Out1, Scale1), Dst + 4);
+			VectorStore(VectorMultiply(Out2, Scale2), Dst + 8);
+		}
+		return i;
+	}
+
+	/**
+	 * Decodes the elements of an accessor into TElement. Decode is
+	 * instantiated for every component type so the loops have no dispatch.
+	 */
+	template<typename TElement>
+	struct TElementDecoder;
+
+	/** Indices. */
+	template<>
+	struct TElementDecoder<int32>
+	{
+		template<typename TComponent, bool bNormalized>
+		static void Decode(const FGltfAccessorView& View, int32* Out)
+		{
+			const int32 Stride = View.GetStride();
+			if(Stride == sizeof(TComponent))
+			{
+				if(sizeof(TComponent) == sizeof(int32) && !std::is_same<TComponent, float>::value)
+				{
+					FMemory::Memcpy(Out, View.Data, View.Count * sizeof(int32));
+					return;
+				}
+
+				// Contiguous widening, the compiler vectorizes it.
+				for(int32 i = 0; i < View.Count; i++)
+				{
+					Out[i] = static_cast<int32>(ReadComponent<TComponent>(View.Data + i * sizeof(TComponent)));
+				}
+				return;
+			}
+
+			for(int32 i = 0; i < View.Count; i++)
+			{
+				Out[i] = static_cast<int32>(ReadComponent<TComponent>(View.Data + Stride * i));
+			}
+		}
+	};
+
+	/** Positions and normals, converted to Unreal coordinates. */
+	template<>
+	struct TElementDecoder<FVector>
+	{
+		template<typename TComponent, bool bNormalized>
+		static void Decode(const FGltfAccessorView& View, FVector* Out)
+		{
+			const int32 Stride = View.GetStride();
+			int32 i = 0;
+			if(std::is_same<TComponent, float>::value && View.NumComponents == 3 && Stride == 3 * sizeof(float))
+			{
+				i = DecodePackedVectors(reinterpret_cast<const float*>(View.Data), View.Count, Out);
+			}
+
+			for(; i < View.Count; i++)
+			{
+				float Values[3];
+				ReadFloats<TComponent, bNormalized>(View.Data + Stride * i, View.NumComponents, 0.0f, Values);
+				Out[i] = FVector(-Values[2] * 100, Values[0] * 100, Values[1] * 100);
+			}
+		}
+	};
+
+	/** Texture coordinates. */
+	template<>
+	struct TElementDecoder<FVector2D>
+	{
+		template<typename TComponent, bool bNormalized>
+		static void Decode(const FGltfAccessorView& View, FVector2D* Out)
+		{
+			const int32 Stride = View.GetStride();
+			if(std::is_same<TComponent, float>::value && View.NumComponents == 2 && Stride == sizeof(FVector2D))
+			{
+				FMemory::Memcpy(Out, View.Data, View.Count * sizeof(FVector2D));
+				return;
+			}
+
+			for(int32 i = 0; i < View.Count; i++)
+			{
+				float Values[2];
+				ReadFloats<TComponent, bNormalized>(View.Data + Stride * i, View.NumComponents, 0.0f, Values);
+				Out[i] = FVector2D(Values[0], Values[1]);
+			}
+		}
+	};
+
+	/** Vertex colors, RGB colors are opaque. */
+	template<>
+	struct TElementDecoder<FColor>
+	{
+		template<typename TComponent, bool bNormalized>
+		static void Decode(const FGltfAccessorView& View, FColor* Out)
+		{
+			const int32 Stride = View.GetStride();
+			for(int32 i = 0; i < View.Count; i++)
+			{
+				float Values[4];
+				ReadFloats<TComponent, bNormalized>(View.Data + Stride * i, View.NumComponents, 1.0f, Values);
+				Out[i] = FLinearColor(Values[0], Values[1], Values[2], Values[3]).ToFColor(false);
+			}
+		}
+	};
+
+	template<typename TElement, typename TComponent>
+	FORCEINLINE void DecodeAs(const FGltfAccessorView& View, TElement* Out)
+	{
+		if(View.bNormalized)
+		{
+			TElementDecoder<TElement>::template Decode<TComponent, true>(View, Out);
+		}
+		else
+		{
+			TElementDecoder<TElement>::template Decode<TComponent, false>(View, Out);
+		}
+	}
+}
+
+/**
+ * Decodes every element of View into Out, which must have room for
+ * View.Count elements. TElement is one of int32 (indices), FVector (positions
+ * and normals, converted to Unreal coordinates), FVector2D or FColor.
+ */
+template<typename TElement>
+void DecodeGltfAccessor(const FGltfAccessorView& View, TElement* Out)
+{
+	using namespace GltfAccessorImpl;
+
+	if(View.Data == NULL)
+	{
+		FMemory::Memzero(Out, View.Count * sizeof(TElement));
+		return;
+	}
+
+	switch(View.ComponentType)
+	{
+		case EGltfComponentType::Byte:
+			DecodeAs<TElement, int8>(View, Out);
+			break;
+		case EGltfComponentType::UnsignedByte:
+			DecodeAs<TElement, uint8>(View, Out);
+			break;
+		case EGltfComponentType::Short:
+			DecodeAs<TElement, int16>(View, Out);
+			break;
+		case EGltfComponentType::UnsignedShort:
+			DecodeAs<TElement, uint16>(View, Out);
+			break;
+		case EGltfComponentType::Int:
+			DecodeAs<TElement, int32>(View, Out);
+			break;
+		case EGltfComponentType::UnsignedInt:
+			DecodeAs<TElement, uint32>(View, Out);
+			break;
+		case EGltfComponentType::Float:
+			DecodeAs<TElement, float>(View, Out);
+			break;
+		default:
+			FMemory::Memzero(Out, View.Count * sizeof(TElement));
+			break;
+	}
+}
+
+/** Decodes every element of View into a new array. */
+template<typename TElement>
+TArray<TElement> LoadGltfAccessor(const FGltfAccessorView& View)
+{
+	TArray<TElement> Elements;
+
+	// Every element is written by the decoder, no need to initialize them.
+	Elements.SetNumUninitialized(View.Count);
+	DecodeGltfAccessor(View, Elements.GetData());
+	return Elements;
+}
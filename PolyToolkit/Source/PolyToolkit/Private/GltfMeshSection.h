@@ -0,0 +1,45 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+
+/**
+ * Primitives with fewer vertices decode their attributes one after the
+ * other, splitting them over tasks would cost more than it saves.
+ */
+const int32 GltfParallelAttributesMinVertices = 16 * 1024;
+
+/**
+ * poly.ParallelDecode, 0 decodes the primitives of a model and their
+ * attributes on the import worker alone. Mostly to measure what the
+ * parallel decode saves.
+ */
+extern TAutoConsoleVariable<int32> CVarPolyParallelDecode;
+
+/**
+ * Geometry of a mesh section decoded from glTF accessors, in Unreal
+ * coordinates and ready to be handed to UProceduralMeshComponent. Attributes
+ * the primitive does not have are left empty.
+ */
+struct FGltfMeshSection
+{
+	TArray<FVector> Vertices;
+	TArray<int32> Triangles;
+	TArray<FVector> Normals;
+	TArray<FVector2D> TextCoords;
+	TArray<FColor> VertexColors;
+};
@@ -14,20 +14,85 @@
 
 #include "CoreMinimal.h"
 #include "HttpDownload.h"
+#include "PolyDownloadScheduler.h"
+#include "PolyFileIO.h"
+#include "PolyToolkit.h"
+#include "HAL/FileManager.h"
 
-void UHttpDownload::Download(const FPolyFile& File, const FString& AssetName, UPolyToolkit* PolyToolkit)
+#define HTTP_RESPONSE_PARTIAL_CONTENT 206
+#define HTTP_RESPONSE_RANGE_NOT_SATISFIABLE 416
+
+// Size of the ranges files streamed to disk are requested by. A download
+// holds at most two of them in memory, one being written and one received.
+#define STREAMED_RANGE_BYTES (4 * 1024 * 1024)
+
+// Reads the start of the range and the size of the whole file, -1 if the
+// server does not know it, from a Content-Range header.
+static bool ParseContentRange(const FString& ContentRange, int64& Start, int64& Total)
+{
+	FString Range;
+	FString Size;
+	if(!ContentRange.StartsWith(TEXT("bytes ")) || !ContentRange.Mid(6).Split(TEXT("/"), &Range, &Size))
+	{
+		return false;
+	}
+	if(Range.IsEmpty() || !FChar::IsDigit(Range[0]))
+	{
+		return false;
+	}
+	Start = FCString::Atoi64(*Range);
+	Total = Size == TEXT("*") ? -1 : FCString::Atoi64(*Size);
+	return true;
+}
+
+void UHttpDownload::Download(const FPolyFile& File, const FString& AssetName, const FString& AssetVersion, bool KeepInMemory, const FString& StagingPath, UPolyDownloadScheduler* Scheduler)
 {
 	HttpModule = &FHttpModule::Get();
 	this->File = File;
 	this->AssetName = AssetName;
-	this->PolyToolkit = PolyToolkit;
+	this->AssetVersion = AssetVersion;
+	this->KeepInMemory = KeepInMemory;
+	this->Scheduler = Scheduler;
+	if(KeepInMemory)
+	{
+		TSharedRef<IHttpRequest> Request = CreateRequest();
+		Request->OnProcessRequestComplete().BindUObject(this, &UHttpDownload::OnDownloadResourceResponseReceived);
+		Request->ProcessRequest();
+		return;
+	}
+
+	// Buffering a whole file before writing it doubles its size in memory and
+	// ends with a long write. Files going to disk are requested by ranges
+	// instead, each written on the I/O thread while the next one arrives.
+	Stream = MakeShareable(new FStream());
+	Stream->Path = GetResourcePath(AssetName, File.relativePath);
+	Stream->PartPath = FString::Printf(TEXT("%s.%s.part"), *Stream->Path, *FGuid::NewGuid().ToString());
+	Stream->StagingPath = StagingPath;
+	NextOffset = 0;
+	TotalSize = -1;
+	bWritingRange = false;
+	bStreamFailed = false;
+	RequestRange();
+}
+
+FString UHttpDownload::GetResourcePath(const FString& AssetName, const FString& RelativePath)
+{
+#if PLATFORM_ANDROID
+	FString base = "/HelloPolyToolkit/Content/";
+#else
+	FString base = FPaths::ConvertRelativePathToFull(FPaths::ProjectContentDir());
+#endif
+	return FPaths::Combine(base, AssetName, RelativePath);
+}
+
+TSharedRef<IHttpRequest> UHttpDownload::CreateRequest()
+{
 	TSharedRef<IHttpRequest> Request = HttpModule->CreateRequest();
-	Request->OnProcessRequestComplete().BindUObject(this, &UHttpDownload::OnDownloadResourceResponseReceived);
 	Request->SetURL(File.url);
 	Request->SetVerb("GET");
 	Request->SetHeader(TEXT("User-Agent"), "X-UnrealEngine-Agent");
 	Request->SetHeader("Content-Type", TEXT("application/x-www-form-urlencoded"));
-	Request->ProcessRequest();
+	return Request;
 }
 
 void UHttpDownload::OnDownloadResourceResponseReceived(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful)
@@ -36,16 +101,224 @@ void UHttpDownload::OnDownloadResourceResponseReceived(FHttpRequestPtr Request,
 	{
 		if(Response->GetResponseCode() == HTTP_RESPONSE_OK)
 		{
-#if PLATFORM_ANDROID
-			FString base = "/HelloPolyToolkit/Content/";
-#else
-			FString base = FPaths::ConvertRelativePathToFull(FPaths::ProjectContentDir());
-#endif
-			FString path = FPaths::Combine(base, AssetName, File.relativePath);
-			FFileHelper::SaveArrayToFile(Response->GetContent(),*path);
-			PolyToolkit->OnDownloadResourceComplete(false);
+			Content = Response->GetContent();
+			Scheduler->OnDownloadComplete(this, true);
 			return;
 		}
 	}
-	PolyToolkit->OnDownloadResourceComplete(false);
+	Scheduler->OnDownloadComplete(this, false);
+}
+
+void UHttpDownload::RequestRange()
+{
+	TSharedRef<IHttpRequest> Request = CreateRequest();
+	Request->OnProcessRequestComplete().BindUObject(this, &UHttpDownload::OnRangeReceived);
+	Request->SetHeader(TEXT("Range"), FString::Printf(TEXT("bytes=%lld-%lld"), NextOffset, NextOffset + STREAMED_RANGE_BYTES - 1));
+	Request->ProcessRequest();
+}
+
+void UHttpDownload::OnRangeReceived(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful)
+{
+	if(bStreamFailed)
+	{
+		return;
+	}
+	if(!Response.IsValid() || !bWasSuccessful)
+	{
+		FailStream();
+		return;
+	}
+
+	int64 Received = Response->GetContent().Num();
+	int32 ResponseCode = Response->GetResponseCode();
+	if(ResponseCode == HTTP_RESPONSE_OK && NextOffset == 0)
+	{
+		// The server ignored the range and sent the whole file.
+		TotalSize = Received;
+	}
+	else if(ResponseCode == HTTP_RESPONSE_PARTIAL_CONTENT)
+	{
+		int64 Start = 0;
+		if(!ParseContentRange(Response->GetHeader(TEXT("Content-Range")), Start, TotalSize) || Start != NextOffset)
+		{
+			FailStream();
+			return;
+		}
+		if(TotalSize < 0 && Received < STREAMED_RANGE_BYTES)
+		{
+			TotalSize = NextOffset + Received;
+		}
+	}
+	else if(ResponseCode == HTTP_RESPONSE_RANGE_NOT_SATISFIABLE)
+	{
+		// Asked past the end of a file of unknown size, or the file is empty.
+		// The body only describes the error.
+		TotalSize = NextOffset;
+		Received = 0;
+	}
+	else
+	{
+		FailStream();
+		return;
+	}
+
+	NextOffset += Received;
+	if(Received > 0)
+	{
+		if(bWritingRange)
+		{
+			PendingRange = Response;
+		}
+		else
+		{
+			WriteRange(Response);
+		}
+	}
+
+	// A range waiting for the disk holds the next request back, so a slow disk
+	// does not fill the memory with ranges.
+	if(PendingRange.IsValid())
+	{
+		return;
+	}
+	if(TotalSize < 0 || NextOffset < TotalSize)
+	{
+		RequestRange();
+	}
+	else if(!bWritingRange)
+	{
+		FinishStream();
+	}
+}
+
+void UHttpDownload::WriteRange(FHttpResponsePtr Response)
+{
+	bWritingRange = true;
+	TSharedPtr<FStream, ESPMode::ThreadSafe> WrittenStream = Stream;
+	TWeakObjectPtr<UHttpDownload> WeakThis(this);
+	FPolyFileIO::Run([WrittenStream, Response]()
+	{
+		return WriteToStream(*WrittenStream, Response->GetContent());
+	},
+	[WeakThis](bool bWritten)
+	{
+		if(WeakThis.IsValid())
+		{
+			WeakThis->OnRangeWritten(bWritten);
+		}
+	});
+}
+
+void UHttpDownload::OnRangeWritten(bool bWritten)
+{
+	bWritingRange = false;
+	if(!bWritten || bStreamFailed)
+	{
+		FailStream();
+		return;
+	}
+
+	bool bReceived = TotalSize >= 0 && NextOffset >= TotalSize;
+	if(PendingRange.IsValid())
+	{
+		FHttpResponsePtr Next = PendingRange;
+		PendingRange.Reset();
+		WriteRange(Next);
+		if(!bReceived)
+		{
+			RequestRange();
+		}
+	}
+	else if(bReceived)
+	{
+		FinishStream();
+	}
+}
+
+void UHttpDownload::FinishStream()
+{
+	TSharedPtr<FStream, ESPMode::ThreadSafe> FinishedStream = Stream;
+	TWeakObjectPtr<UHttpDownload> WeakThis(this);
+	FPolyFileIO::Run([FinishedStream]()
+	{
+		return CloseStream(*FinishedStream);
+	},
+	[WeakThis](bool bFinished)
+	{
+		if(WeakThis.IsValid())
+		{
+			WeakThis->OnStreamFinished(bFinished);
+		}
+	});
+}
+
+void UHttpDownload::OnStreamFinished(bool bFinished)
+{
+	Scheduler->OnDownloadComplete(this, bFinished);
+}
+
+void UHttpDownload::FailStream()
+{
+	bStreamFailed = true;
+	PendingRange.Reset();
+	if(bWritingRange)
+	{
+		// Done once the range being written lets go of the file.
+		return;
+	}
+
+	TSharedPtr<FStream, ESPMode::ThreadSafe> FailedStream = Stream;
+	FPolyFileIO::Run([FailedStream]()
+	{
+		FailedStream->Writer.Reset();
+		return IFileManager::Get().Delete(*FailedStream->PartPath, false, false, true);
+	});
+	Scheduler->OnDownloadComplete(this, false);
+}
+
+bool UHttpDownload::WriteToStream(FStream& Destination, const TArray<uint8>& Data)
+{
+	// Ranges go to a temporary file, an interrupted download never leaves a
+	// truncated file where the importer would look for it. Its name is unique
+	// so two downloads of a file, say of two versions of the asset, never
+	// write the same one.
+	if(!Destination.Writer.IsValid())
+	{
+		Destination.Writer.Reset(IFileManager::Get().CreateFileWriter(*Destination.PartPath));
+		if(!Destination.Writer.IsValid())
+		{
+			return false;
+		}
+	}
+	Destination.Writer->Serialize(const_cast<uint8*>(Data.GetData()), Data.Num());
+	Destination.Sha.Update(Data.GetData(), Data.Num());
+	Destination.Size += Data.Num();
+	return !Destination.Writer->IsError();
+}
+
+bool UHttpDownload::CloseStream(FStream& Destination)
+{
+	const FString& PartPath = Destination.PartPath;
+	if(!Destination.Writer.IsValid())
+	{
+		// Empty files have no range to write.
+		Destination.Writer.Reset(IFileManager::Get().CreateFileWriter(*PartPath));
+	}
+	bool bClosed = Destination.Writer.IsValid() && Destination.Writer->Close();
+	Destination.Writer.Reset();
+	Destination.Sha.Final();
+	Destination.Sha.GetHash(Destination.Hash.Hash);
+
+	if(!bClosed || !IFileManager::Get().Move(*Destination.Path, *PartPath, true, true))
+	{
+		IFileManager::Get().Delete(*PartPath, false, false, true);
+		return false;
+	}
+
+	// A file that could not be staged is only left out of the disk cache.
+	if(!Destination.StagingPath.IsEmpty() && IFileManager::Get().Copy(*Destination.StagingPath, *Destination.Path) != COPY_OK)
+	{
+		Destination.StagingPath.Empty();
+	}
+	return true;
 }
@@ -16,11 +16,13 @@
 
 #include "CoreMinimal.h"
 #include "Runtime/Online/HTTP/Public/Http.h"
+#include "Misc/SecureHash.h"
 #include "PolyAsset.h"
-#include "PolyToolkit.h"
 
 #include "HttpDownload.generated.h"
 
+class UPolyDownloadScheduler;
+
 UCLASS()
 class UHttpDownload : public UObject
 {
@@ -28,16 +30,90 @@ class UHttpDownload : public UObject
 
 public:
 	/**
-	 * Download a PolyFile and store it the the game's content folder. Calls
-	 * PolyToolkit OnDownloadResourceComplete when the download is completed.
+	 * Download a PolyFile and store it the the game's content folder, or keep
+	 * it in memory if KeepInMemory is true. Files stored on disk are streamed
+	 * there by ranges and, if StagingPath is not empty, copied to it for the
+	 * disk cache. Calls Scheduler OnDownloadComplete when the download is
+	 * completed.
 	 */
-	void Download(const FPolyFile& File, const FString& AssetName, UPolyToolkit* PolyToolkit);
+	void Download(const FPolyFile& File, const FString& AssetName, const FString& AssetVersion, bool KeepInMemory, const FString& StagingPath, UPolyDownloadScheduler* Scheduler);
+
+	/** Full path a file of AssetName is stored at when it is not kept in memory. */
+	static FString GetResourcePath(const FString& AssetName, const FString& RelativePath);
+
+	/** The file being downloaded. */
+	const FPolyFile& GetFile() const { return File; }
+
+	/** Version of the asset the file belongs to, see FPolyAsset::updateTime. */
+	const FString& GetAssetVersion() const { return AssetVersion; }
+
+	/** Contents of a file kept in memory, until the scheduler is done with it. */
+	TArray<uint8>& GetContent() { return Content; }
+
+	/** True if the file was streamed to disk, GetContent is then empty. */
+	bool IsStreamed() const { return !KeepInMemory; }
+
+	/** Name of the asset the file is stored under when it is not kept in memory. */
+	const FString& GetAssetName() const { return AssetName; }
+
+	/** True if a streamed file was also copied to its staging path. */
+	bool IsStaged() const { return Stream.IsValid() && !Stream->StagingPath.IsEmpty(); }
+
+	/** Path a staged file was copied to. */
+	const FString& GetStagingPath() const { return Stream->StagingPath; }
+
+	/** Hash of the contents of a completed streamed file. */
+	const FSHAHash& GetStreamedHash() const { return Stream->Hash; }
+
+	/** Size of a completed streamed file. */
+	int64 GetStreamedSize() const { return Stream->Size; }
+
 private:
+	// Destination of a streamed file. Only touched by the range being written,
+	// on the I/O thread, or by the game thread when no range is.
+	struct FStream
+	{
+		FString Path;
+		FString PartPath;
+		FString StagingPath;
+		TUniquePtr<FArchive> Writer;
+		FSHA1 Sha;
+		FSHAHash Hash;
+		int64 Size = 0;
+	};
+
+	TSharedRef<IHttpRequest> CreateRequest();
 	void OnDownloadResourceResponseReceived(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful);
 
+	// Streamed files, see Download.
+	void RequestRange();
+	void OnRangeReceived(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful);
+	void WriteRange(FHttpResponsePtr Response);
+	void OnRangeWritten(bool bWritten);
+	void FinishStream();
+	void OnStreamFinished(bool bFinished);
+	void FailStream();
+	static bool WriteToStream(FStream& Destination, const TArray<uint8>& Data);
+	static bool CloseStream(FStream& Destination);
+
 	FPolyFile File;
 	FString AssetName;
+	FString AssetVersion;
+	bool KeepInMemory;
+	TArray<uint8> Content;
+
+	TSharedPtr<FStream, ESPMode::ThreadSafe> Stream;
+
+	// Offset of the next range to request, and size of the file once known,
+	// -1 until then.
+	int64 NextOffset;
+	int64 TotalSize;
+
+	// A range is being written, and one received while it was.
+	bool bWritingRange;
+	FHttpResponsePtr PendingRange;
+	bool bStreamFailed;
 	FHttpModule* HttpModule;
-	UPolyToolkit* PolyToolkit;
+	UPolyDownloadScheduler* Scheduler;
 };
 
@@ -0,0 +1,177 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "CoreMinimal.h"
+#include "PolyAssetCatalog.h"
+
+// Bit of Format in the format mask of an Asset, 0 for formats Poly does not
+// report in formatType.
+static uint8 GetFormatBit(const FString& FormatType)
+{
+	for(uint8 Format = 0; Format < static_cast<uint8>(EPolyFormat::Any); Format++)
+	{
+		if(FormatType == EPolyFormatToString(static_cast<EPolyFormat>(Format)))
+		{
+			return 1 << Format;
+		}
+	}
+	return 0;
+}
+
+UPolyAssetCatalog::UPolyAssetCatalog(const class FObjectInitializer& PCIP) : Super(PCIP)
+{
+}
+
+void UPolyAssetCatalog::AddAssets(const FPolyAssetList& AssetList, EPolyCategory Category)
+{
+	for(const FPolyAsset& Asset : AssetList.assets)
+	{
+		int32 Index;
+		const int32* Existing = AssetsByName.Find(Asset.name);
+		if(Existing != NULL)
+		{
+			Index = *Existing;
+			Assets[Index] = Asset;
+
+			// An Asset listed without a category keeps the one it was listed with.
+			if(Category != EPolyCategory::Any)
+			{
+				Categories[Index] = Category;
+			}
+		}
+		else
+		{
+			Index = Assets.Add(Asset);
+			AssetsByName.Add(Asset.name, Index);
+			FormatMasks.AddUninitialized();
+			Categories.Add(Category);
+			TriangleCounts.AddUninitialized();
+			CreateTimes.AddUninitialized();
+			Authors.AddUninitialized();
+			Curated.AddUninitialized();
+		}
+
+		// Parse once what queries look at.
+		uint8 FormatMask = 0;
+		int32 TriangleCount = 0;
+		for(const FPolyFormat& Format : Asset.formats)
+		{
+			FormatMask |= GetFormatBit(Format.formatType);
+			int64 FormatTriangles = FCString::Atoi64(*Format.format_complexity.triangleCount);
+			if(FormatTriangles > 0 && (TriangleCount == 0 || FormatTriangles < TriangleCount))
+			{
+				TriangleCount = static_cast<int32>(FMath::Min<int64>(FormatTriangles, MAX_int32));
+			}
+		}
+		FDateTime CreateTime;
+		if(!FDateTime::ParseIso8601(*Asset.createTime, CreateTime))
+		{
+			CreateTime = FDateTime(0);
+		}
+
+		FormatMasks[Index] = FormatMask;
+		TriangleCounts[Index] = TriangleCount;
+		CreateTimes[Index] = CreateTime.GetTicks();
+		Authors[Index] = InternAuthor(Asset.authorName);
+		Curated[Index] = Asset.is_curated;
+	}
+}
+
+TArray<int32> UPolyAssetCatalog::Query(const FPolyCatalogFilter& Filter, EPolyCatalogOrder OrderBy) const
+{
+	TArray<int32> Result;
+
+	// Resolve the filter once, the scan only compares integers.
+	const uint8 FormatBit = Filter.Format != EPolyFormat::Any ? 1 << static_cast<uint8>(Filter.Format) : 0;
+	int32 Author = INDEX_NONE;
+	if(!Filter.AuthorName.IsEmpty())
+	{
+		const int32* Found = AuthorIds.Find(Filter.AuthorName);
+		if(Found == NULL)
+		{
+			return Result;
+		}
+		Author = *Found;
+	}
+
+	Result.Reserve(Assets.Num());
+	for(int32 i = 0; i < Assets.Num(); i++)
+	{
+		if((FormatMasks[i] & FormatBit) != FormatBit
+			|| (Filter.Category != EPolyCategory::Any && Categories[i] != Filter.Category)
+			|| (Author != INDEX_NONE && Authors[i] != Author)
+			|| (Filter.MaxTriangleCount > 0 && (TriangleCounts[i] == 0 || TriangleCounts[i] > Filter.MaxTriangleCount))
+			|| (Filter.CuratedOnly && !Curated[i]))
+		{
+			continue;
+		}
+		Result.Add(i);
+	}
+
+	// Ties keep the order Assets were added in, which is the order Poly returned them.
+	switch(OrderBy)
+	{
+		case EPolyCatalogOrder::Newest:
+			Result.StableSort([this](int32 A, int32 B) { return CreateTimes[A] > CreateTimes[B]; });
+			break;
+		case EPolyCatalogOrder::Oldest:
+			Result.StableSort([this](int32 A, int32 B) { return CreateTimes[A] < CreateTimes[B]; });
+			break;
+		case EPolyCatalogOrder::FewestTriangles:
+			Result.StableSort([this](int32 A, int32 B) { return TriangleCounts[A] < TriangleCounts[B]; });
+			break;
+		case EPolyCatalogOrder::MostTriangles:
+			Result.StableSort([this](int32 A, int32 B) { return TriangleCounts[A] > TriangleCounts[B]; });
+			break;
+		case EPolyCatalogOrder::DisplayName:
+			Result.StableSort([this](int32 A, int32 B) { return Assets[A].displayName < Assets[B].displayName; });
+			break;
+		case EPolyCatalogOrder::AuthorName:
+			Result.StableSort([this](int32 A, int32 B) { return Authors[A] != Authors[B] && AuthorNames[Authors[A]] < AuthorNames[Authors[B]]; });
+			break;
+	}
+	return Result;
+}
+
+FPolyAsset UPolyAssetCatalog::GetAsset(int32 Index) const
+{
+	return Assets.IsValidIndex(Index) ? Assets[Index] : FPolyAsset();
+}
+
+void UPolyAssetCatalog::Empty()
+{
+	Assets.Empty();
+	AssetsByName.Empty();
+	FormatMasks.Empty();
+	Categories.Empty();
+	TriangleCounts.Empty();
+	CreateTimes.Empty();
+	Authors.Empty();
+	Curated.Empty();
+	AuthorNames.Empty();
+	AuthorIds.Empty();
+}
+
+int32 UPolyAssetCatalog::InternAuthor(const FString& AuthorName)
+{
+	const int32* Found = AuthorIds.Find(AuthorName);
+	if(Found != NULL)
+	{
+		return *Found;
+	}
+	int32 Author = AuthorNames.Add(AuthorName);
+	AuthorIds.Add(AuthorName, Author);
+	return Author;
+}
@@ -0,0 +1,179 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "CoreMinimal.h"
+#include "PolyAssetJson.h"
+#include "PolyJsonReader.h"
+
+// Keys are the ones of the Poly API. The snake case ones of older responses
+// are read too.
+
+static bool ReadFile(FPolyJsonReader& Reader, FPolyFile& File)
+{
+	return Reader.ReadObject([&Reader, &File](const FPolyJsonKey& Key)
+	{
+		if(Key == "relativePath")
+		{
+			return Reader.ReadString(File.relativePath);
+		}
+		if(Key == "url")
+		{
+			return Reader.ReadString(File.url);
+		}
+		if(Key == "contentType")
+		{
+			return Reader.ReadString(File.contentType);
+		}
+		return Reader.SkipValue();
+	});
+}
+
+static bool ReadFormatComplexity(FPolyJsonReader& Reader, FPolyFormatComplexity& Complexity)
+{
+	return Reader.ReadObject([&Reader, &Complexity](const FPolyJsonKey& Key)
+	{
+		if(Key == "triangleCount")
+		{
+			int64 TriangleCount;
+			if(!Reader.ReadInt64(TriangleCount))
+			{
+				return false;
+			}
+			Complexity.triangleCount = FString::Printf(TEXT("%lld"), TriangleCount);
+			return true;
+		}
+		if(Key == "lodHint" || Key == "lod_hint")
+		{
+			return Reader.ReadInt32(Complexity.lod_hint);
+		}
+		return Reader.SkipValue();
+	});
+}
+
+static bool ReadFormat(FPolyJsonReader& Reader, FPolyFormat& Format)
+{
+	Format.format_complexity.lod_hint = 0;
+	return Reader.ReadObject([&Reader, &Format](const FPolyJsonKey& Key)
+	{
+		if(Key == "root")
+		{
+			return ReadFile(Reader, Format.root);
+		}
+		if(Key == "resources")
+		{
+			return Reader.ReadArray([&Reader, &Format]()
+			{
+				return ReadFile(Reader, Format.resources[Format.resources.AddDefaulted()]);
+			});
+		}
+		if(Key == "formatComplexity" || Key == "format_complexity")
+		{
+			return ReadFormatComplexity(Reader, Format.format_complexity);
+		}
+		if(Key == "formatType")
+		{
+			return Reader.ReadString(Format.formatType);
+		}
+		return Reader.SkipValue();
+	});
+}
+
+static bool ReadAsset(FPolyJsonReader& Reader, FPolyAsset& Asset)
+{
+	Asset.is_curated = false;
+	return Reader.ReadObject([&Reader, &Asset](const FPolyJsonKey& Key)
+	{
+		if(Key == "name")
+		{
+			return Reader.ReadString(Asset.name);
+		}
+		if(Key == "displayName")
+		{
+			return Reader.ReadString(Asset.displayName);
+		}
+		if(Key == "authorName")
+		{
+			return Reader.ReadString(Asset.authorName);
+		}
+		if(Key == "description")
+		{
+			return Reader.ReadString(Asset.description);
+		}
+		if(Key == "createTime")
+		{
+			return Reader.ReadString(Asset.createTime);
+		}
+		if(Key == "updateTime")
+		{
+			return Reader.ReadString(Asset.updateTime);
+		}
+		if(Key == "formats")
+		{
+			return Reader.ReadArray([&Reader, &Asset]()
+			{
+				return ReadFormat(Reader, Asset.formats[Asset.formats.AddDefaulted()]);
+			});
+		}
+		if(Key == "thumbnail")
+		{
+			return ReadFile(Reader, Asset.thumbnail);
+		}
+		if(Key == "license")
+		{
+			return Reader.ReadString(Asset.license);
+		}
+		if(Key == "visibility")
+		{
+			return Reader.ReadString(Asset.visibility);
+		}
+		if(Key == "isCurated" || Key == "is_curated")
+		{
+			return Reader.ReadBool(Asset.is_curated);
+		}
+		return Reader.SkipValue();
+	});
+}
+
+bool ParsePolyAsset(const TArray<uint8>& Json, FPolyAsset& Asset)
+{
+	FPolyJsonReader Reader(Json.GetData(), Json.Num());
+	return ReadAsset(Reader, Asset) && Reader.IsAtEnd();
+}
+
+bool ParsePolyAssetList(const TArray<uint8>& Json, FPolyAssetList& AssetList)
+{
+	FPolyJsonReader Reader(Json.GetData(), Json.Num());
+	AssetList.totalSize = 0;
+	bool bParsed = Reader.ReadObject([&Reader, &AssetList](const FPolyJsonKey& Key)
+	{
+		if(Key == "assets")
+		{
+			return Reader.ReadArray([&Reader, &AssetList]()
+			{
+				return ReadAsset(Reader, AssetList.assets[AssetList.assets.AddDefaulted()]);
+			});
+		}
+		if(Key == "nextPageToken")
+		{
+			return Reader.ReadString(AssetList.nextPageToken);
+		}
+		if(Key == "totalSize")
+		{
+			return Reader.ReadInt32(AssetList.totalSize);
+		}
+		return Reader.SkipValue();
+	});
+	return bParsed && Reader.IsAtEnd();
+}
@@ -0,0 +1,28 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PolyAsset.h"
+#include "PolyAssetList.h"
+
+/**
+ * Decoders of the Poly API responses, reading the UTF-8 body straight into
+ * the structs. They create no UObject and can run on any thread. Fields
+ * the structs do not have are skipped.
+ */
+bool ParsePolyAsset(const TArray<uint8>& Json, FPolyAsset& Asset);
+bool ParsePolyAssetList(const TArray<uint8>& Json, FPolyAssetList& AssetList);
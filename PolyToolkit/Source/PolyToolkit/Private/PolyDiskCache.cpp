@@ -0,0 +1,715 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CoreMinimal.h"
+#include "PolyDiskCache.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "PolyFileIO.h"
+#include "Serialization/MemoryWriter.h"
+
+#define DEFAULT_DISK_CACHE_MAX_BYTES (256 * 1024 * 1024)
+
+// Size of the chunks cached files are copied by, see Copy.
+#define DISK_CACHE_COPY_CHUNK_BYTES (1024 * 1024)
+
+// Identifies the index file format, bump it when the entries change.
+#define DISK_CACHE_INDEX_MAGIC 0x31435044 // "PDC1"
+
+UPolyDiskCache::UPolyDiskCache(const class FObjectInitializer& PCIP) : Super(PCIP)
+{
+	CacheDir = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("PolyToolkit"), TEXT("DiskCache"));
+	TotalBytes = 0;
+	MaxBytes = DEFAULT_DISK_CACHE_MAX_BYTES;
+	AccessCounter = 0;
+	bIndexLoaded = false;
+	bIndexDirty = false;
+	Generation = 0;
+	PendingStores = 0;
+}
+
+void UPolyDiskCache::PostInitProperties()
+{
+	Super::PostInitProperties();
+	if(!HasAnyFlags(RF_ClassDefaultObject))
+	{
+		LoadIndex();
+	}
+}
+
+bool UPolyDiskCache::Load(const FPolyFile& File, const FString& AssetVersion, TFunction<void(bool, TArray<uint8>&)> OnLoaded)
+{
+	if(HoldUntilIndexLoaded([this, File, AssetVersion, OnLoaded]()
+	{
+		if(!Load(File, AssetVersion, OnLoaded))
+		{
+			TArray<uint8> Content;
+			OnLoaded(false, Content);
+		}
+	}))
+	{
+		return true;
+	}
+
+	FSHAHash Key;
+	const FEntry* Entry = UseEntry(File, AssetVersion, Key);
+	if(Entry == NULL)
+	{
+		return false;
+	}
+
+	// The file may have been deleted or damaged behind our back, it is then
+	// downloaded again. Checking it takes a hash of the whole file, done with
+	// the read alongside the other file operations. That also catches a
+	// file evicted while it is read.
+	FSHAHash Blob = Entry->Blob;
+	int64 Size = Entry->Size;
+	FString Path = GetBlobPath(CacheDir, Blob);
+	FString Url = File.url;
+	TSharedRef<TArray<uint8>, ESPMode::ThreadSafe> Content = MakeShareable(new TArray<uint8>());
+	BlobReads.FindOrAdd(Blob)++;
+	TWeakObjectPtr<UPolyDiskCache> WeakThis(this);
+	FPolyFileIO::Read([Content, Path, Blob, Size]()
+	{
+		if(!FFileHelper::LoadFileToArray(*Content, *Path, FILEREAD_Silent) || Content->Num() != Size)
+		{
+			return false;
+		}
+		FSHAHash Hash;
+		FSHA1::HashBuffer(Content->GetData(), Content->Num(), Hash.Hash);
+		return Hash == Blob;
+	},
+	[WeakThis, Key, Blob, Url, Content, OnLoaded](bool bLoaded)
+	{
+		if(!bLoaded)
+		{
+			Content->Empty();
+		}
+		if(WeakThis.IsValid())
+		{
+			WeakThis->OnRead(Key, Blob, Url, bLoaded);
+		}
+		OnLoaded(bLoaded, *Content);
+	});
+	return true;
+}
+
+bool UPolyDiskCache::Map(const FPolyFile& File, const FString& AssetVersion, TFunction<void(TSharedPtr<FPolyMappedFile, ESPMode::ThreadSafe>)> OnMapped)
+{
+	if(HoldUntilIndexLoaded([this, File, AssetVersion, OnMapped]()
+	{
+		if(!Map(File, AssetVersion, OnMapped))
+		{
+			OnMapped(TSharedPtr<FPolyMappedFile, ESPMode::ThreadSafe>());
+		}
+	}))
+	{
+		return true;
+	}
+
+	FSHAHash Key;
+	const FEntry* Entry = UseEntry(File, AssetVersion, Key);
+	if(Entry == NULL)
+	{
+		return false;
+	}
+
+	// Checked like Load does, the hash reads every page of the mapping once
+	// and the caller reads them again from memory.
+	FSHAHash Blob = Entry->Blob;
+	int64 Size = Entry->Size;
+	FString Path = GetBlobPath(CacheDir, Blob);
+	FString Url = File.url;
+	TSharedRef<TSharedPtr<FPolyMappedFile, ESPMode::ThreadSafe>, ESPMode::ThreadSafe> Mapped = MakeShareable(new TSharedPtr<FPolyMappedFile, ESPMode::ThreadSafe>());
+	BlobReads.FindOrAdd(Blob)++;
+	TWeakObjectPtr<UPolyDiskCache> WeakThis(this);
+	FPolyFileIO::Read([Mapped, Path, Blob, Size]()
+	{
+		*Mapped = FPolyMappedFile::Open(Path, Size);
+		if(!Mapped->IsValid() || IFileManager::Get().FileSize(*Path) != Size)
+		{
+			return false;
+		}
+		FSHAHash Hash;
+		FSHA1::HashBuffer((*Mapped)->GetData(), Size, Hash.Hash);
+		return Hash == Blob;
+	},
+	[WeakThis, Key, Blob, Url, Mapped, OnMapped](bool bMapped)
+	{
+		if(!bMapped)
+		{
+			Mapped->Reset();
+		}
+		if(WeakThis.IsValid())
+		{
+			WeakThis->OnRead(Key, Blob, Url, bMapped);
+		}
+		OnMapped(*Mapped);
+	});
+	return true;
+}
+
+bool UPolyDiskCache::Copy(const FPolyFile& File, const FString& AssetVersion, const FString& Path, TFunction<void(bool)> OnCopied)
+{
+	if(HoldUntilIndexLoaded([this, File, AssetVersion, Path, OnCopied]()
+	{
+		if(!Copy(File, AssetVersion, Path, OnCopied))
+		{
+			OnCopied(false);
+		}
+	}))
+	{
+		return true;
+	}
+
+	FSHAHash Key;
+	const FEntry* Entry = UseEntry(File, AssetVersion, Key);
+	if(Entry == NULL)
+	{
+		return false;
+	}
+
+	// Checked like Load does, by chunks hashed as they are copied. Writing Path
+	// makes it a queued operation rather than a read.
+	FSHAHash Blob = Entry->Blob;
+	int64 Size = Entry->Size;
+	FString BlobPath = GetBlobPath(CacheDir, Blob);
+	FString Url = File.url;
+	TSharedRef<bool, ESPMode::ThreadSafe> bIntact = MakeShareable(new bool(false));
+	BlobReads.FindOrAdd(Blob)++;
+	TWeakObjectPtr<UPolyDiskCache> WeakThis(this);
+	FPolyFileIO::Run([BlobPath, Blob, Size, Path, bIntact]()
+	{
+		return CopyBlob(BlobPath, Blob, Size, Path, *bIntact);
+	},
+	[WeakThis, Key, Blob, Url, bIntact, OnCopied](bool bCopied)
+	{
+		if(WeakThis.IsValid())
+		{
+			WeakThis->OnRead(Key, Blob, Url, *bIntact);
+		}
+		OnCopied(bCopied);
+	});
+	return true;
+}
+
+void UPolyDiskCache::Store(const FPolyFile& File, const FString& AssetVersion, TArray<uint8> Content)
+{
+	Store(File, AssetVersion, FPolySharedContent(MakeShareable(new TArray<uint8>(MoveTemp(Content)))));
+}
+
+void UPolyDiskCache::Store(const FPolyFile& File, const FString& AssetVersion, const FPolySharedContent& Content)
+{
+	check(IsInGameThread());
+	if(MaxBytes <= 0 || Content->Num() > MaxBytes)
+	{
+		return;
+	}
+	if(HoldUntilIndexLoaded([this, File, AssetVersion, Content]()
+	{
+		Store(File, AssetVersion, Content);
+	}))
+	{
+		return;
+	}
+
+	// The entry is added once the file is written, the name of the file is
+	// only known once it is hashed.
+	FSHAHash Key = GetKey(File, AssetVersion);
+	int64 Size = Content->Num();
+	FString Dir = CacheDir;
+	FString Url = File.url;
+	uint32 StoreGeneration = Generation;
+	PendingStores++;
+	TSharedRef<FSHAHash, ESPMode::ThreadSafe> Blob = MakeShareable(new FSHAHash());
+	TWeakObjectPtr<UPolyDiskCache> WeakThis(this);
+	FPolyFileIO::Run([Content, Blob, Dir, Url]()
+	{
+		FSHA1::HashBuffer(Content->GetData(), Content->Num(), Blob->Hash);
+
+		// Files with the same contents are only written once.
+		FString Path = GetBlobPath(Dir, *Blob);
+		bool bWritten = IFileManager::Get().FileSize(*Path) == Content->Num() || FFileHelper::SaveArrayToFile(*Content, *Path);
+		if(!bWritten)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Could not cache %s"), *Url);
+		}
+		return bWritten;
+	},
+	[WeakThis, Key, Blob, Size, StoreGeneration](bool bWritten)
+	{
+		if(WeakThis.IsValid())
+		{
+			WeakThis->OnStored(Key, *Blob, Size, StoreGeneration, bWritten);
+		}
+	});
+}
+
+FString UPolyDiskCache::GetStagingPath() const
+{
+	if(MaxBytes <= 0)
+	{
+		return FString();
+	}
+
+	// Every download gets its own file, two of them never write the same one.
+	return FPaths::Combine(GetStagingDir(), FGuid::NewGuid().ToString());
+}
+
+void UPolyDiskCache::StoreStagedFile(const FPolyFile& File, const FString& AssetVersion, const FString& StagingPath, const FSHAHash& Blob, int64 Size)
+{
+	check(IsInGameThread());
+	if(MaxBytes <= 0 || Size > MaxBytes)
+	{
+		FPolyFileIO::Delete(StagingPath);
+		return;
+	}
+	if(HoldUntilIndexLoaded([this, File, AssetVersion, StagingPath, Blob, Size]()
+	{
+		StoreStagedFile(File, AssetVersion, StagingPath, Blob, Size);
+	}))
+	{
+		return;
+	}
+
+	// The staged file is already on the same disk, adding it is a rename.
+	FSHAHash Key = GetKey(File, AssetVersion);
+	FString BlobPath = GetBlobPath(CacheDir, Blob);
+	FString Url = File.url;
+	uint32 StoreGeneration = Generation;
+	PendingStores++;
+	TWeakObjectPtr<UPolyDiskCache> WeakThis(this);
+	FPolyFileIO::Run([StagingPath, BlobPath, Url]()
+	{
+		if(!IFileManager::Get().Move(*BlobPath, *StagingPath, true, true))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Could not cache %s"), *Url);
+			IFileManager::Get().Delete(*StagingPath, false, false, true);
+			return false;
+		}
+		return true;
+	},
+	[WeakThis, Key, Blob, Size, StoreGeneration](bool bMoved)
+	{
+		if(WeakThis.IsValid())
+		{
+			WeakThis->OnStored(Key, Blob, Size, StoreGeneration, bMoved);
+		}
+	});
+}
+
+void UPolyDiskCache::SetMaxBytes(int64 InMaxBytes)
+{
+	check(IsInGameThread());
+	MaxBytes = FMath::Max<int64>(0, InMaxBytes);
+	if(MaxBytes == 0)
+	{
+		Empty();
+		return;
+	}
+
+	// Otherwise done once the index is read.
+	if(bIndexLoaded)
+	{
+		Evict();
+	}
+}
+
+void UPolyDiskCache::Empty()
+{
+	check(IsInGameThread());
+	Entries.Empty();
+	BlobReferences.Empty();
+	TotalBytes = 0;
+	AccessCounter = 0;
+	bIndexLoaded = true;
+	Generation++;
+
+	// The index goes with the files, the one being read too.
+	bIndexDirty = false;
+	FPolyFileIO::DeleteDirectory(CacheDir);
+	RunHeldCalls();
+}
+
+void UPolyDiskCache::Flush()
+{
+	if(!bIndexDirty)
+	{
+		return;
+	}
+	bIndexDirty = false;
+
+	// The index is small, only writing it is left to the I/O thread.
+	FString IndexPath = GetIndexPath();
+	TSharedRef<TArray<uint8>, ESPMode::ThreadSafe> Index = MakeShareable(new TArray<uint8>());
+	SerializeIndex(*Index);
+	FPolyFileIO::Run([Index, IndexPath]()
+	{
+		return WriteIndex(IndexPath, *Index);
+	});
+}
+
+void UPolyDiskCache::BeginDestroy()
+{
+	// Nothing can be queued at exit, finish what is and write the index here.
+	FPolyFileIO::Wait();
+	if(bIndexDirty)
+	{
+		bIndexDirty = false;
+		TArray<uint8> Index;
+		SerializeIndex(Index);
+		WriteIndex(GetIndexPath(), Index);
+	}
+	Super::BeginDestroy();
+}
+
+FSHAHash UPolyDiskCache::GetKey(const FPolyFile& File, const FString& AssetVersion)
+{
+	FTCHARToUTF8 Url(*File.url);
+	FTCHARToUTF8 Version(*AssetVersion);
+	const uint8 Separator = '\n';
+
+	FSHA1 Sha;
+	Sha.Update(reinterpret_cast<const uint8*>(Url.Get()), Url.Length());
+	Sha.Update(&Separator, 1);
+	Sha.Update(reinterpret_cast<const uint8*>(Version.Get()), Version.Length());
+	Sha.Final();
+
+	FSHAHash Key;
+	Sha.GetHash(Key.Hash);
+	return Key;
+}
+
+const UPolyDiskCache::FEntry* UPolyDiskCache::UseEntry(const FPolyFile& File, const FString& AssetVersion, FSHAHash& Key)
+{
+	check(IsInGameThread());
+	if(MaxBytes <= 0)
+	{
+		return NULL;
+	}
+
+	Key = GetKey(File, AssetVersion);
+	FEntry* Entry = Entries.Find(Key);
+	if(Entry == NULL)
+	{
+		return NULL;
+	}
+	Entry->LastAccess = ++AccessCounter;
+	bIndexDirty = true;
+	return Entry;
+}
+
+FString UPolyDiskCache::GetBlobPath(const FString& Dir, const FSHAHash& Blob)
+{
+	// Spread the files over 256 folders so none gets too large.
+	FString Name = Blob.ToString();
+	return FPaths::Combine(Dir, Name.Left(2), Name);
+}
+
+FString UPolyDiskCache::GetIndexPath() const
+{
+	return FPaths::Combine(CacheDir, TEXT("Index.bin"));
+}
+
+FString UPolyDiskCache::GetStagingDir() const
+{
+	return FPaths::Combine(CacheDir, TEXT("Staging"));
+}
+
+void UPolyDiskCache::SerializeIndex(TArray<uint8>& Index)
+{
+	FMemoryWriter Writer(Index);
+	uint32 Magic = DISK_CACHE_INDEX_MAGIC;
+	int32 Num = Entries.Num();
+	Writer << Magic << Num;
+	for(auto& Entry : Entries)
+	{
+		FSHAHash Key = Entry.Key;
+		Writer << Key << Entry.Value.Blob << Entry.Value.Size << Entry.Value.LastAccess;
+	}
+}
+
+bool UPolyDiskCache::WriteIndex(const FString& IndexPath, const TArray<uint8>& Index)
+{
+	// Write a new index next to the old one and swap them, a crash while
+	// writing leaves the old index intact.
+	FString TempPath = IndexPath + TEXT(".tmp");
+	if(!FFileHelper::SaveArrayToFile(Index, *TempPath) || !IFileManager::Get().Move(*IndexPath, *TempPath, true, true))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not write the disk cache index"));
+		IFileManager::Get().Delete(*TempPath, false, false, true);
+		return false;
+	}
+	return true;
+}
+
+bool UPolyDiskCache::CopyBlob(const FString& BlobPath, const FSHAHash& Blob, int64 Size, const FString& Path, bool& bIntact)
+{
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*BlobPath, FILEREAD_Silent));
+	if(!Reader.IsValid() || Reader->TotalSize() != Size)
+	{
+		return false;
+	}
+
+	// The copy goes to a temporary file renamed once the hash matched, a
+	// damaged file never ends up where the importer would look for it.
+	FString TempPath = FString::Printf(TEXT("%s.%s.tmp"), *Path, *FGuid::NewGuid().ToString());
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*TempPath));
+	bool bWritten = Writer.IsValid();
+
+	FSHA1 Sha;
+	TArray<uint8> Chunk;
+	Chunk.SetNumUninitialized(FMath::Min<int64>(Size, DISK_CACHE_COPY_CHUNK_BYTES));
+	for(int64 Offset = 0; Offset < Size && !Reader->IsError(); Offset += Chunk.Num())
+	{
+		int32 ChunkBytes = (int32)FMath::Min<int64>(Size - Offset, Chunk.Num());
+		Reader->Serialize(Chunk.GetData(), ChunkBytes);
+		Sha.Update(Chunk.GetData(), ChunkBytes);
+		if(bWritten)
+		{
+			Writer->Serialize(Chunk.GetData(), ChunkBytes);
+		}
+	}
+	Sha.Final();
+	FSHAHash Hash;
+	Sha.GetHash(Hash.Hash);
+	bIntact = !Reader->IsError() && Hash == Blob;
+	Reader.Reset();
+
+	bWritten = bWritten && !Writer->IsError() && Writer->Close();
+	Writer.Reset();
+	if(!bIntact || !bWritten || !IFileManager::Get().Move(*Path, *TempPath, true, true))
+	{
+		IFileManager::Get().Delete(*TempPath, false, false, true);
+		return false;
+	}
+	return true;
+}
+
+void UPolyDiskCache::LoadIndex()
+{
+	// Files left staged by a previous run that did not finish are never
+	// stored, they are deleted before this run stages any.
+	FPolyFileIO::DeleteDirectory(GetStagingDir());
+
+	// Only the index is read, files are checked when they are loaded.
+	FString IndexPath = GetIndexPath();
+	TSharedRef<TMap<FSHAHash, FEntry>, ESPMode::ThreadSafe> IndexEntries = MakeShareable(new TMap<FSHAHash, FEntry>());
+	TWeakObjectPtr<UPolyDiskCache> WeakThis(this);
+	FPolyFileIO::Run([IndexPath, IndexEntries]()
+	{
+		return ReadIndex(IndexPath, *IndexEntries);
+	},
+	[WeakThis, IndexEntries](bool bValid)
+	{
+		if(WeakThis.IsValid())
+		{
+			WeakThis->OnIndexLoaded(*IndexEntries, bValid);
+		}
+	});
+}
+
+bool UPolyDiskCache::ReadIndex(const FString& IndexPath, TMap<FSHAHash, FEntry>& IndexEntries)
+{
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*IndexPath, FILEREAD_Silent));
+	if(!Reader.IsValid())
+	{
+		return true;
+	}
+
+	uint32 Magic = 0;
+	int32 Num = 0;
+	*Reader << Magic << Num;
+	if(Magic != DISK_CACHE_INDEX_MAGIC || Num < 0)
+	{
+		return false;
+	}
+	IndexEntries.Reserve(Num);
+	for(int32 i = 0; i < Num && !Reader->IsError(); i++)
+	{
+		FSHAHash Key;
+		FEntry Entry;
+		*Reader << Key << Entry.Blob << Entry.Size << Entry.LastAccess;
+		IndexEntries.Add(Key, Entry);
+	}
+	return !Reader->IsError();
+}
+
+void UPolyDiskCache::OnIndexLoaded(TMap<FSHAHash, FEntry>& IndexEntries, bool bValid)
+{
+	// Unless the cache was emptied while the index was read.
+	if(bIndexLoaded)
+	{
+		return;
+	}
+	if(!bValid)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Disk cache index is damaged, the cache is cleared"));
+		Empty();
+		return;
+	}
+
+	bIndexLoaded = true;
+	Entries = MoveTemp(IndexEntries);
+	for(auto& Entry : Entries)
+	{
+		if(BlobReferences.FindOrAdd(Entry.Value.Blob)++ == 0)
+		{
+			TotalBytes += Entry.Value.Size;
+		}
+		AccessCounter = FMath::Max(AccessCounter, Entry.Value.LastAccess);
+	}
+
+	// The budget may have been lowered while the index was read.
+	Evict();
+	RunHeldCalls();
+}
+
+bool UPolyDiskCache::HoldUntilIndexLoaded(TFunction<void()> Call)
+{
+	if(bIndexLoaded)
+	{
+		return false;
+	}
+	HeldCalls.Add(MoveTemp(Call));
+	return true;
+}
+
+void UPolyDiskCache::RunHeldCalls()
+{
+	TArray<TFunction<void()>> Calls = MoveTemp(HeldCalls);
+	HeldCalls.Empty();
+	for(auto& Call : Calls)
+	{
+		Call();
+	}
+}
+
+void UPolyDiskCache::Evict()
+{
+	if(TotalBytes <= MaxBytes)
+	{
+		return;
+	}
+
+	// Go a bit under the budget so the next files do not evict again right away.
+	const int64 TargetBytes = MaxBytes - MaxBytes / 10;
+	TArray<TPair<uint64, FSHAHash>> ByAccess;
+	ByAccess.Reserve(Entries.Num());
+	for(auto& Entry : Entries)
+	{
+		ByAccess.Add(TPair<uint64, FSHAHash>(Entry.Value.LastAccess, Entry.Key));
+	}
+	ByAccess.Sort([](const TPair<uint64, FSHAHash>& A, const TPair<uint64, FSHAHash>& B)
+	{
+		return A.Key < B.Key;
+	});
+
+	for(int32 i = 0; i < ByAccess.Num() && TotalBytes > TargetBytes; i++)
+	{
+		RemoveEntry(ByAccess[i].Value);
+	}
+}
+
+void UPolyDiskCache::RemoveEntry(const FSHAHash& Key)
+{
+	FEntry Entry;
+	if(!Entries.RemoveAndCopyValue(Key, Entry))
+	{
+		return;
+	}
+	bIndexDirty = true;
+
+	int32& References = BlobReferences.FindChecked(Entry.Blob);
+	if(--References == 0)
+	{
+		BlobReferences.Remove(Entry.Blob);
+		TotalBytes -= Entry.Size;
+
+		// A file being read is deleted by OnRead once it is done.
+		if(!BlobReads.Contains(Entry.Blob))
+		{
+			FPolyFileIO::Delete(GetBlobPath(CacheDir, Entry.Blob));
+		}
+	}
+}
+
+void UPolyDiskCache::OnRead(const FSHAHash& Key, const FSHAHash& Blob, const FString& Url, bool bRead)
+{
+	int32& Reads = BlobReads.FindChecked(Blob);
+	if(--Reads == 0)
+	{
+		BlobReads.Remove(Blob);
+
+		// The file was evicted or the cache emptied while it was read.
+		if(!BlobReferences.Contains(Blob))
+		{
+			FPolyFileIO::Delete(GetBlobPath(CacheDir, Blob));
+		}
+	}
+
+	if(!bRead)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Cached copy of %s is missing or damaged"), *Url);
+		FEntry* Entry = Entries.Find(Key);
+		if(Entry != NULL && Entry->Blob == Blob)
+		{
+			RemoveEntry(Key);
+		}
+	}
+}
+
+void UPolyDiskCache::OnStored(const FSHAHash& Key, const FSHAHash& Blob, int64 Size, uint32 StoreGeneration, bool bStored)
+{
+	// Unless the cache was emptied or disabled while the file was written,
+	// the file then went with the others.
+	if(bStored && StoreGeneration == Generation && MaxBytes > 0)
+	{
+		AddEntry(Key, Blob, Size);
+	}
+
+	// Files written after the index was saved would be forgotten by the next
+	// run, save it again once the last one is in.
+	if(--PendingStores == 0)
+	{
+		Flush();
+	}
+}
+
+void UPolyDiskCache::AddEntry(const FSHAHash& Key, const FSHAHash& Blob, int64 Size)
+{
+	FEntry* Existing = Entries.Find(Key);
+	if(Existing != NULL && Existing->Blob == Blob)
+	{
+		Existing->LastAccess = ++AccessCounter;
+		bIndexDirty = true;
+		return;
+	}
+	RemoveEntry(Key);
+
+	if(BlobReferences.FindOrAdd(Blob)++ == 0)
+	{
+		TotalBytes += Size;
+	}
+
+	FEntry Entry;
+	Entry.Blob = Blob;
+	Entry.Size = Size;
+	Entry.LastAccess = ++AccessCounter;
+	Entries.Add(Key, Entry);
+	bIndexDirty = true;
+
+	Evict();
+}
@@ -0,0 +1,164 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/SecureHash.h"
+#include "PolyAsset.h"
+#include "PolyFileIO.h"
+
+#include "PolyDiskCache.generated.h"
+
+/**
+ * Downloaded files kept on disk between runs, so importing an asset again
+ * makes no request. Files are looked up by URL and version of their asset,
+ * and stored by hash of their contents so identical files are kept once.
+ * When the files go over the size budget the least recently used ones are
+ * deleted. The index of the files is read off the game thread when the
+ * cache is created, calls made before it is read wait for it. Must be used
+ * from the game thread.
+ */
+UCLASS()
+class UPolyDiskCache : public UObject
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	/**
+	 * Reads the cached contents of File in the AssetVersion of its asset off
+	 * the game thread. Returns false if the file is not cached, otherwise
+	 * OnLoaded is called with the contents, which it can move from, or with
+	 * false if the cached copy turned out damaged. While the index is read,
+	 * returns true and OnLoaded is called with false if the file turns out
+	 * not to be cached.
+	 */
+	bool Load(const FPolyFile& File, const FString& AssetVersion, TFunction<void(bool, TArray<uint8>&)> OnLoaded);
+
+	/**
+	 * Same as Load, except the cached file is mapped instead of read into an
+	 * array. OnMapped is called with NULL if the cached copy turned out
+	 * damaged.
+	 */
+	bool Map(const FPolyFile& File, const FString& AssetVersion, TFunction<void(TSharedPtr<FPolyMappedFile, ESPMode::ThreadSafe>)> OnMapped);
+
+	/**
+	 * Same as Load, except the cached file is copied to Path, replacing what
+	 * is there, without ever being held in memory whole. OnCopied is called
+	 * with false if the cached copy turned out damaged or Path could not be
+	 * written.
+	 */
+	bool Copy(const FPolyFile& File, const FString& AssetVersion, const FString& Path, TFunction<void(bool)> OnCopied);
+
+	/**
+	 * Caches the contents of File, then evicts files until the cache fits its
+	 * budget. The file is hashed and written off the game thread, it can only
+	 * be loaded once that is done.
+	 */
+	void Store(const FPolyFile& File, const FString& AssetVersion, TArray<uint8> Content);
+
+	/** Same as Store for contents the caller keeps using, they are not copied. */
+	void Store(const FPolyFile& File, const FString& AssetVersion, const FPolySharedContent& Content);
+
+	/**
+	 * New path a file can be written at, from any thread, before being handed
+	 * to StoreStagedFile. Empty if the cache is disabled.
+	 */
+	FString GetStagingPath() const;
+
+	/**
+	 * Same as Store for a file written at StagingPath, whose contents hash as
+	 * Blob. The staged file is moved into the cache or deleted.
+	 */
+	void StoreStagedFile(const FPolyFile& File, const FString& AssetVersion, const FString& StagingPath, const FSHAHash& Blob, int64 Size);
+
+	/** Sets the size budget of the cache. 0 disables it and deletes every file. */
+	void SetMaxBytes(int64 InMaxBytes);
+
+	/** False if the size budget of the cache is 0, nothing is then stored. */
+	bool IsEnabled() const { return MaxBytes > 0; }
+
+	/** Deletes every cached file. */
+	void Empty();
+
+	/** Writes the index, off the game thread, if it changed since it was last written. */
+	void Flush();
+
+	virtual void PostInitProperties() override;
+	virtual void BeginDestroy() override;
+
+private:
+	struct FEntry
+	{
+		// Hash of the contents, names the file holding them.
+		FSHAHash Blob;
+
+		int64 Size;
+
+		// Value of AccessCounter the last time the entry was used.
+		uint64 LastAccess;
+	};
+
+	static FSHAHash GetKey(const FPolyFile& File, const FString& AssetVersion);
+
+	// Entry of File, marked as used, or NULL if it is not cached.
+	const FEntry* UseEntry(const FPolyFile& File, const FString& AssetVersion, FSHAHash& Key);
+	static FString GetBlobPath(const FString& Dir, const FSHAHash& Blob);
+	FString GetIndexPath() const;
+	FString GetStagingDir() const;
+
+	void LoadIndex();
+	static bool ReadIndex(const FString& IndexPath, TMap<FSHAHash, FEntry>& IndexEntries);
+	void OnIndexLoaded(TMap<FSHAHash, FEntry>& IndexEntries, bool bValid);
+
+	// Keeps Call for once the index is read, false if it already is.
+	bool HoldUntilIndexLoaded(TFunction<void()> Call);
+	void RunHeldCalls();
+	void SerializeIndex(TArray<uint8>& Index);
+	static bool WriteIndex(const FString& IndexPath, const TArray<uint8>& Index);
+	static bool CopyBlob(const FString& BlobPath, const FSHAHash& Blob, int64 Size, const FString& Path, bool& bIntact);
+	void Evict();
+	void AddEntry(const FSHAHash& Key, const FSHAHash& Blob, int64 Size);
+	void RemoveEntry(const FSHAHash& Key);
+
+	// Back on the game thread once a file was loaded or written.
+	void OnRead(const FSHAHash& Key, const FSHAHash& Blob, const FString& Url, bool bRead);
+	void OnStored(const FSHAHash& Key, const FSHAHash& Blob, int64 Size, uint32 StoreGeneration, bool bStored);
+
+	// Cache entries by hash of the URL and asset version.
+	TMap<FSHAHash, FEntry> Entries;
+
+	// Number of entries using each file.
+	TMap<FSHAHash, int32> BlobReferences;
+
+	// Number of reads of each file in progress. Reads do not wait for the
+	// queued file operations, files are only deleted once nobody reads them.
+	TMap<FSHAHash, int32> BlobReads;
+
+	FString CacheDir;
+	int64 TotalBytes;
+	int64 MaxBytes;
+	uint64 AccessCounter;
+	bool bIndexLoaded;
+	bool bIndexDirty;
+
+	// Bumped when the cache is emptied, files written for it before are dropped.
+	uint32 Generation;
+
+	// Files being written for Store or StoreStagedFile.
+	int32 PendingStores;
+
+	// Calls made while the index is read, in the order they were made.
+	TArray<TFunction<void()>> HeldCalls;
+};
@@ -0,0 +1,217 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CoreMinimal.h"
+#include "PolyDownloadScheduler.h"
+#include "HttpDownload.h"
+#include "PolyDiskCache.h"
+#include "PolyFileIO.h"
+#include "PolyImportSession.h"
+#include "PolyToolkit.h"
+
+// Browsers use 6 connections per host, poly.googleapis.com serves every file.
+#define DEFAULT_MAX_CONCURRENT_DOWNLOADS 6
+
+UPolyDownloadScheduler::UPolyDownloadScheduler(const class FObjectInitializer& PCIP) : Super(PCIP)
+{
+	MaxConcurrentDownloads = DEFAULT_MAX_CONCURRENT_DOWNLOADS;
+}
+
+EPolyDownloadPriority UPolyDownloadScheduler::GetResourcePriority(const FPolyFile& File)
+{
+	if(File.contentType.StartsWith(TEXT("image/")))
+	{
+		return EPolyDownloadPriority::Texture;
+	}
+	return EPolyDownloadPriority::Buffer;
+}
+
+void UPolyDownloadScheduler::Enqueue(UPolyImportSession* ImportSession, const FPolyFile& File, const FString& AssetName, const FString& AssetVersion, bool KeepInMemory, EPolyDownloadPriority Priority)
+{
+	FQueuedDownload QueuedDownload;
+	QueuedDownload.ImportSession = ImportSession;
+	QueuedDownload.File = File;
+	QueuedDownload.AssetName = AssetName;
+	QueuedDownload.AssetVersion = AssetVersion;
+	QueuedDownload.KeepInMemory = KeepInMemory;
+	QueuedDownload.Priority = Priority;
+
+	// Files already downloaded for this version of the asset make no request,
+	// unless the cached copy turns out damaged once read. Files going to disk
+	// are copied there from the cache without passing through memory.
+	TWeakObjectPtr<UPolyDownloadScheduler> WeakThis(this);
+	TWeakObjectPtr<UPolyImportSession> WeakSession(ImportSession);
+	UPolyDiskCache* DiskCache = UPolyToolkit::GetPolyToolkitInstance()->GetDiskCache();
+	bool bCached = false;
+	if(KeepInMemory)
+	{
+		bCached = DiskCache->Load(File, AssetVersion, [WeakThis, WeakSession, QueuedDownload](bool bLoaded, TArray<uint8>& Content)
+		{
+			if(!WeakThis.IsValid() || !WeakSession.IsValid())
+			{
+				return;
+			}
+			if(!bLoaded)
+			{
+				WeakThis->QueueDownload(QueuedDownload);
+				return;
+			}
+			WeakSession->OnDownloadResourceComplete(QueuedDownload.File, true, MakeShareable(new TArray<uint8>(MoveTemp(Content))));
+		});
+	}
+	else
+	{
+		bCached = DiskCache->Copy(File, AssetVersion, UHttpDownload::GetResourcePath(AssetName, File.relativePath), [WeakThis, WeakSession, QueuedDownload](bool bCopied)
+		{
+			if(!WeakThis.IsValid() || !WeakSession.IsValid())
+			{
+				return;
+			}
+			if(!bCopied)
+			{
+				WeakThis->QueueDownload(QueuedDownload);
+				return;
+			}
+			WeakSession->OnDownloadResourceComplete(QueuedDownload.File, true, MakeShareable(new TArray<uint8>()));
+		});
+	}
+	if(!bCached)
+	{
+		QueueDownload(QueuedDownload);
+	}
+}
+
+void UPolyDownloadScheduler::QueueDownload(const FQueuedDownload& QueuedDownload)
+{
+	// Imports of the same asset at once share the downloads of its files, two
+	// downloads of a file would also write the same file on disk. A shared
+	// download waiting for a slot goes first if the new import needs it sooner.
+	for(auto& Active : ActiveDownloads)
+	{
+		UHttpDownload* Download = Active.Key;
+		if(IsSameDownload(QueuedDownload, Download->GetFile(), Download->GetAssetName(), Download->GetAssetVersion(), !Download->IsStreamed()))
+		{
+			SharedDownloads.FindOrAdd(Download).Add(QueuedDownload.ImportSession);
+			return;
+		}
+	}
+	for(FQueuedDownload& Queued : Queue)
+	{
+		if(IsSameDownload(QueuedDownload, Queued.File, Queued.AssetName, Queued.AssetVersion, Queued.KeepInMemory))
+		{
+			Queued.SharedWith.Add(QueuedDownload.ImportSession);
+			Queued.Priority = FMath::Min(Queued.Priority, QueuedDownload.Priority);
+			return;
+		}
+	}
+
+	Queue.Add(QueuedDownload);
+	DispatchDownloads();
+}
+
+bool UPolyDownloadScheduler::IsSameDownload(const FQueuedDownload& QueuedDownload, const FPolyFile& File, const FString& AssetName, const FString& AssetVersion, bool KeepInMemory)
+{
+	// Files stored on disk must also go to the same place, imports of the
+	// same asset store it under the same name.
+	return QueuedDownload.File.url == File.url
+		&& QueuedDownload.File.relativePath == File.relativePath
+		&& QueuedDownload.AssetVersion == AssetVersion
+		&& QueuedDownload.KeepInMemory == KeepInMemory
+		&& (KeepInMemory || QueuedDownload.AssetName == AssetName);
+}
+
+void UPolyDownloadScheduler::OnDownloadComplete(UHttpDownload* Download, bool Status)
+{
+	UPolyImportSession* ImportSession = NULL;
+	if(!ActiveDownloads.RemoveAndCopyValue(Download, ImportSession))
+	{
+		return;
+	}
+
+	TArray<UPolyImportSession*> SharedWith;
+	SharedDownloads.RemoveAndCopyValue(Download, SharedWith);
+
+	int32& SessionDownloads = ActiveDownloadsPerSession.FindChecked(ImportSession);
+	if(--SessionDownloads == 0)
+	{
+		ActiveDownloadsPerSession.Remove(ImportSession);
+	}
+
+	// The cache and the session share the downloaded file, neither copies it.
+	FPolySharedContent Content = MakeShareable(new TArray<uint8>(MoveTemp(Download->GetContent())));
+	UPolyDiskCache* DiskCache = UPolyToolkit::GetPolyToolkitInstance()->GetDiskCache();
+	if(Status && !Download->IsStreamed())
+	{
+		DiskCache->Store(Download->GetFile(), Download->GetAssetVersion(), Content);
+	}
+	else if(Status && Download->IsStaged())
+	{
+		DiskCache->StoreStagedFile(Download->GetFile(), Download->GetAssetVersion(), Download->GetStagingPath(), Download->GetStreamedHash(), Download->GetStreamedSize());
+	}
+
+	// Refill the free slot before notifying the session, the last download of
+	// an import triggers the model loading which can take a while.
+	DispatchDownloads();
+	ImportSession->OnDownloadResourceComplete(Download->GetFile(), Status, Content);
+	for(UPolyImportSession* SharedSession : SharedWith)
+	{
+		SharedSession->OnDownloadResourceComplete(Download->GetFile(), Status, Content);
+	}
+}
+
+void UPolyDownloadScheduler::SetMaxConcurrentDownloads(int32 MaxDownloads)
+{
+	MaxConcurrentDownloads = FMath::Max(1, MaxDownloads);
+	DispatchDownloads();
+}
+
+void UPolyDownloadScheduler::DispatchDownloads()
+{
+	while(ActiveDownloads.Num() < MaxConcurrentDownloads && Queue.Num() > 0)
+	{
+		int32 Index = FindNextDownload();
+		FQueuedDownload Next = Queue[Index];
+		Queue.RemoveAt(Index, 1, false);
+
+		UHttpDownload* Download = NewObject<UHttpDownload>(this);
+		ActiveDownloads.Add(Download, Next.ImportSession);
+		ActiveDownloadsPerSession.FindOrAdd(Next.ImportSession)++;
+		if(Next.SharedWith.Num() > 0)
+		{
+			SharedDownloads.Add(Download, MoveTemp(Next.SharedWith));
+		}
+		FString StagingPath = Next.KeepInMemory ? FString() : UPolyToolkit::GetPolyToolkitInstance()->GetDiskCache()->GetStagingPath();
+		Download->Download(Next.File, Next.AssetName, Next.AssetVersion, Next.KeepInMemory, StagingPath, this);
+	}
+}
+
+int32 UPolyDownloadScheduler::FindNextDownload() const
+{
+	// The queue is in arrival order, so ties are resolved first come first served.
+	int32 Best = INDEX_NONE;
+	int32 BestSessionDownloads = 0;
+	for(int32 i = 0; i < Queue.Num(); i++)
+	{
+		const int32* Found = ActiveDownloadsPerSession.Find(Queue[i].ImportSession);
+		int32 SessionDownloads = Found ? *Found : 0;
+		if(Best == INDEX_NONE
+			|| Queue[i].Priority < Queue[Best].Priority
+			|| (Queue[i].Priority == Queue[Best].Priority && SessionDownloads < BestSessionDownloads))
+		{
+			Best = i;
+			BestSessionDownloads = SessionDownloads;
+		}
+	}
+	return Best;
+}
@@ -0,0 +1,103 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PolyAsset.h"
+
+#include "PolyDownloadScheduler.generated.h"
+
+class UHttpDownload;
+class UPolyImportSession;
+
+/**
+ * Order in which queued files are downloaded. Lower values go first.
+ */
+enum class EPolyDownloadPriority : uint8
+{
+	Root,
+	Buffer,
+	Texture
+};
+
+/**
+ * Queues the file downloads of every import and runs at most
+ * MaxConcurrentDownloads of them at a time. Files are started by priority
+ * and, within the same priority, from the import with the fewest downloads
+ * in flight so a large asset does not starve the others. Files found in the
+ * disk cache are not downloaded, downloaded ones are added to it. A file
+ * several imports wait for at once is downloaded once for all of them.
+ */
+UCLASS()
+class UPolyDownloadScheduler : public UObject
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	/** Picks the priority of a file based on its role and content type. */
+	static EPolyDownloadPriority GetResourcePriority(const FPolyFile& File);
+
+	/**
+	 * Queues a download of File. ImportSession OnDownloadResourceComplete is
+	 * called once the file is downloaded, or read from the disk cache if it
+	 * has it for AssetVersion.
+	 */
+	void Enqueue(UPolyImportSession* ImportSession, const FPolyFile& File, const FString& AssetName, const FString& AssetVersion, bool KeepInMemory, EPolyDownloadPriority Priority);
+
+	/** Called by UHttpDownload when its request is done. */
+	void OnDownloadComplete(UHttpDownload* Download, bool Status);
+
+	/** Sets the maximum number of downloads in flight. Values below 1 are clamped to 1. */
+	void SetMaxConcurrentDownloads(int32 MaxDownloads);
+
+	/** Number of downloads waiting for a free slot. */
+	int32 GetQueuedDownloadCount() const { return Queue.Num(); }
+
+	/** Number of downloads in flight. */
+	int32 GetActiveDownloadCount() const { return ActiveDownloads.Num(); }
+
+private:
+	struct FQueuedDownload
+	{
+		UPolyImportSession* ImportSession;
+		FPolyFile File;
+		FString AssetName;
+		FString AssetVersion;
+		bool KeepInMemory;
+		EPolyDownloadPriority Priority;
+
+		// Other imports waiting for the same file.
+		TArray<UPolyImportSession*> SharedWith;
+	};
+
+	void QueueDownload(const FQueuedDownload& QueuedDownload);
+	void DispatchDownloads();
+	int32 FindNextDownload() const;
+	static bool IsSameDownload(const FQueuedDownload& QueuedDownload, const FPolyFile& File, const FString& AssetName, const FString& AssetVersion, bool KeepInMemory);
+
+	TArray<FQueuedDownload> Queue;
+
+	// Downloads in flight and the import that queued them.
+	UPROPERTY()
+	TMap<UHttpDownload*, UPolyImportSession*> ActiveDownloads;
+
+	// Other imports waiting for a download in flight.
+	TMap<UHttpDownload*, TArray<UPolyImportSession*>> SharedDownloads;
+
+	// Number of downloads in flight per import.
+	TMap<UPolyImportSession*, int32> ActiveDownloadsPerSession;
+
+	int32 MaxConcurrentDownloads;
+};
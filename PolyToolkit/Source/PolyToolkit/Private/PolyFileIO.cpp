@@ -0,0 +1,160 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CoreMinimal.h"
+#include "PolyFileIO.h"
+#include "Async/Async.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/ScopeLock.h"
+#include "gltf2/glTF2.hpp"
+
+// Operations waiting for their turn, and whether a task of the thread pool
+// is running them.
+static FCriticalSection FileIOQueueLock;
+static TArray<TFunction<void()>> FileIOQueue;
+static bool bFileIODraining = false;
+
+void FPolyFileIO::Run(TFunction<bool()> Work, TFunction<void(bool)> OnComplete)
+{
+	Enqueue([Work, OnComplete]()
+	{
+		Complete(Work, OnComplete);
+	});
+}
+
+void FPolyFileIO::Read(TFunction<bool()> Work, TFunction<void(bool)> OnComplete)
+{
+	Async<void>(EAsyncExecution::ThreadPool, [Work, OnComplete]()
+	{
+		Complete(Work, OnComplete);
+	});
+}
+
+void FPolyFileIO::Save(const FString& Path, TArray<uint8> Content, TFunction<void(bool)> OnComplete)
+{
+	TSharedRef<TArray<uint8>, ESPMode::ThreadSafe> SharedContent = MakeShareable(new TArray<uint8>(MoveTemp(Content)));
+	Run([Path, SharedContent]()
+	{
+		bool bSaved = FFileHelper::SaveArrayToFile(*SharedContent, *Path);
+		SharedContent->Empty();
+		return bSaved;
+	}, OnComplete);
+}
+
+void FPolyFileIO::Delete(const FString& Path)
+{
+	Run([Path]()
+	{
+		return IFileManager::Get().Delete(*Path, false, false, true);
+	});
+}
+
+void FPolyFileIO::DeleteDirectory(const FString& Path)
+{
+	Run([Path]()
+	{
+		return IFileManager::Get().DeleteDirectory(*Path, false, true);
+	});
+}
+
+void FPolyFileIO::Wait()
+{
+	for(;;)
+	{
+		bool bDrainHere = false;
+		{
+			FScopeLock Lock(&FileIOQueueLock);
+			if(!bFileIODraining)
+			{
+				if(FileIOQueue.Num() == 0)
+				{
+					return;
+				}
+				bFileIODraining = true;
+				bDrainHere = true;
+			}
+		}
+		if(bDrainHere)
+		{
+			Drain();
+		}
+		else
+		{
+			FPlatformProcess::Sleep(0.001f);
+		}
+	}
+}
+
+void FPolyFileIO::Enqueue(TFunction<void()> Operation)
+{
+	FScopeLock Lock(&FileIOQueueLock);
+	FileIOQueue.Add(MoveTemp(Operation));
+	if(!bFileIODraining)
+	{
+		bFileIODraining = true;
+		Async<void>(EAsyncExecution::ThreadPool, &FPolyFileIO::Drain);
+	}
+}
+
+void FPolyFileIO::Complete(const TFunction<bool()>& Work, const TFunction<void(bool)>& OnComplete)
+{
+	bool bResult = Work();
+	if(OnComplete)
+	{
+		AsyncTask(ENamedThreads::GameThread, [OnComplete, bResult]()
+		{
+			OnComplete(bResult);
+		});
+	}
+}
+
+void FPolyFileIO::Drain()
+{
+	for(;;)
+	{
+		TFunction<void()> Operation;
+		{
+			FScopeLock Lock(&FileIOQueueLock);
+			if(FileIOQueue.Num() == 0)
+			{
+				bFileIODraining = false;
+				return;
+			}
+			Operation = MoveTemp(FileIOQueue[0]);
+			FileIOQueue.RemoveAt(0, 1, false);
+		}
+		Operation();
+	}
+}
+
+TSharedPtr<FPolyMappedFile, ESPMode::ThreadSafe> FPolyMappedFile::Open(const FString& Path, int64 Size)
+{
+	TSharedPtr<FPolyMappedFile, ESPMode::ThreadSafe> File = MakeShareable(new FPolyMappedFile());
+	File->View = gltf2::mapFile(TCHAR_TO_ANSI(*Path), Size);
+	if(File->View)
+	{
+		File->Data = reinterpret_cast<const uint8*>(File->View.get());
+	}
+	else
+	{
+		if(!FFileHelper::LoadFileToArray(File->Buffer, *Path, FILEREAD_Silent) || File->Buffer.Num() < Size)
+		{
+			return NULL;
+		}
+		File->Data = File->Buffer.GetData();
+	}
+	File->Size = Size;
+	return File;
+}
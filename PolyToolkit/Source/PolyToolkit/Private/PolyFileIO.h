@@ -0,0 +1,93 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <memory>
+
+/**
+ * Contents of a file handed to several threads at once, for instance to the
+ * disk cache and to the import that downloaded it. Nobody changes them once
+ * they are shared.
+ */
+typedef TSharedRef<const TArray<uint8>, ESPMode::ThreadSafe> FPolySharedContent;
+
+/**
+ * Contents of a file mapped in memory, read only. Pages are only read from
+ * disk when they are first touched, and the file is unmapped with the last
+ * reference to the object. Files that cannot be mapped are read instead.
+ */
+class FPolyMappedFile
+{
+public:
+	/** Maps the first Size bytes of the file at Path, NULL if it is smaller or cannot be read. */
+	static TSharedPtr<FPolyMappedFile, ESPMode::ThreadSafe> Open(const FString& Path, int64 Size);
+
+	const uint8* GetData() const { return Data; }
+	int64 Num() const { return Size; }
+
+private:
+	FPolyMappedFile() : Data(NULL), Size(0) {}
+
+	// Either the mapping or a copy of the file owns Data.
+	std::shared_ptr<const char> View;
+	TArray<uint8> Buffer;
+
+	const uint8* Data;
+	int64 Size;
+};
+
+/**
+ * Runs the file operations of the plugin off the game thread, so disk
+ * latency never stalls a frame. Operations that change files run on the
+ * thread pool one at a time, in the order they were queued: each one sees
+ * the files as the ones queued before it left them. Reads run alongside
+ * them and each other, a large one never holds the others back.
+ * Completion callbacks run on the game thread.
+ */
+class FPolyFileIO
+{
+public:
+	/** Queues Work, then calls OnComplete with what it returned. */
+	static void Run(TFunction<bool()> Work, TFunction<void(bool)> OnComplete = TFunction<void(bool)>());
+
+	/**
+	 * Same as Run for Work that changes no file, started right away instead
+	 * of queued. Files being changed by queued operations can be seen half
+	 * written, Work must check what it reads.
+	 */
+	static void Read(TFunction<bool()> Work, TFunction<void(bool)> OnComplete);
+
+	/** Writes Content to the file at Path, replacing it. */
+	static void Save(const FString& Path, TArray<uint8> Content, TFunction<void(bool)> OnComplete = TFunction<void(bool)>());
+
+	/** Deletes the file at Path, if there is one. */
+	static void Delete(const FString& Path);
+
+	/** Deletes the folder at Path with everything it contains. */
+	static void DeleteDirectory(const FString& Path);
+
+	/**
+	 * Blocks until every queued operation is done, running them on the
+	 * calling thread if none is. Reads are not waited for. Only meant for
+	 * shutdown.
+	 */
+	static void Wait();
+
+private:
+	static void Enqueue(TFunction<void()> Operation);
+	static void Complete(const TFunction<bool()>& Work, const TFunction<void(bool)>& OnComplete);
+	static void Drain();
+};
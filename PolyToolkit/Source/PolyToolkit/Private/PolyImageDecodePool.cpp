@@ -0,0 +1,79 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CoreMinimal.h"
+#include "PolyImageDecodePool.h"
+#include "Async/Async.h"
+#include "IImageWrapperModule.h"
+#include "Misc/FileHelper.h"
+
+void FPolyImageDecodePool::Add(const FString& RelativePath, const FString& ContentType, const FPolySharedContent& Content, const FPolyImportOptions& Options, const UPolyTextureCache* TextureCache)
+{
+	EImageFormat ImageFormat = UGltf2Importer::GetImageFormat(ContentType);
+	Start(RelativePath, [Content, ImageFormat, Options, TextureCache](FGltf2DecodedImage& DecodedImage)
+	{
+		return UGltf2Importer::DecodeImageData(Content->GetData(), Content->Num(), ImageFormat, Options, TextureCache, DecodedImage);
+	});
+}
+
+void FPolyImageDecodePool::AddFile(const FString& RelativePath, const FString& ContentType, const FString& Path, const FPolyImportOptions& Options, const UPolyTextureCache* TextureCache)
+{
+	// The file is complete by the time its download is, it can be read
+	// right away.
+	EImageFormat ImageFormat = UGltf2Importer::GetImageFormat(ContentType);
+	Start(RelativePath, [Path, ImageFormat, Options, TextureCache](FGltf2DecodedImage& DecodedImage)
+	{
+		TArray<uint8> FileData;
+		if(!FFileHelper::LoadFileToArray(FileData, *Path, FILEREAD_Silent))
+		{
+			return false;
+		}
+		return UGltf2Importer::DecodeImageData(FileData.GetData(), FileData.Num(), ImageFormat, Options, TextureCache, DecodedImage);
+	});
+}
+
+bool FPolyImageDecodePool::Take(const FString& RelativePath, FGltf2DecodedImage& DecodedImage)
+{
+	FPendingImage* Pending = Images.Find(RelativePath);
+	if(Pending == NULL || !Pending->Decoded.Get())
+	{
+		return false;
+	}
+	DecodedImage = MoveTemp(*Pending->Image);
+	return true;
+}
+
+void FPolyImageDecodePool::Empty()
+{
+	Images.Empty();
+}
+
+void FPolyImageDecodePool::Start(const FString& RelativePath, TFunction<bool(FGltf2DecodedImage&)> Decode)
+{
+	check(IsInGameThread());
+
+	// Decoders can only be created on workers once the module is loaded.
+	FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+
+	TSharedRef<FGltf2DecodedImage, ESPMode::ThreadSafe> Image = MakeShareable(new FGltf2DecodedImage());
+	FPendingImage Pending =
+	{
+		Image,
+		Async<bool>(EAsyncExecution::ThreadPool, [Image, Decode]()
+		{
+			return Decode(*Image);
+		})
+	};
+	Images.Add(RelativePath, MoveTemp(Pending));
+}
@@ -0,0 +1,63 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Gltf2Importer.h"
+
+class UPolyTextureCache;
+
+/**
+ * Decodes the images of an import on the thread pool as soon as their files
+ * are downloaded, instead of one after another once the model is parsed.
+ * Images are added from the game thread while the files download, and taken
+ * by the importer on its worker once every download is done, never both at
+ * the same time.
+ */
+class FPolyImageDecodePool
+{
+public:
+	/**
+	 * Starts decoding the image in Content, of the MIME type ContentType.
+	 * RelativePath names the file of the image in the asset. Images a
+	 * texture of TextureCache was already decoded from with the same Options
+	 * are skipped.
+	 */
+	void Add(const FString& RelativePath, const FString& ContentType, const FPolySharedContent& Content, const FPolyImportOptions& Options, const UPolyTextureCache* TextureCache);
+
+	/** Same as Add for an image read from the file at Path. */
+	void AddFile(const FString& RelativePath, const FString& ContentType, const FString& Path, const FPolyImportOptions& Options, const UPolyTextureCache* TextureCache);
+
+	/**
+	 * Waits for the image added as RelativePath and moves it to DecodedImage.
+	 * Returns false if there is none, or if it could not be decoded.
+	 */
+	bool Take(const FString& RelativePath, FGltf2DecodedImage& DecodedImage);
+
+	/** Forgets every image, the ones being decoded are dropped once done. */
+	void Empty();
+
+private:
+	struct FPendingImage
+	{
+		TSharedRef<FGltf2DecodedImage, ESPMode::ThreadSafe> Image;
+		TFuture<bool> Decoded;
+	};
+
+	void Start(const FString& RelativePath, TFunction<bool(FGltf2DecodedImage&)> Decode);
+
+	TMap<FString, FPendingImage> Images;
+};
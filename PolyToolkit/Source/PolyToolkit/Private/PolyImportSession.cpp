@@ -0,0 +1,332 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CoreMinimal.h"
+#include "PolyImportSession.h"
+#include "GameFramework/Actor.h"
+#include "Gltf1Importer.h"
+#include "Gltf2Importer.h"
+#include "HttpDownload.h"
+#include "PolyDiskCache.h"
+#include "PolyTextureCache.h"
+#include "IImageWrapperModule.h"
+#include "PolyToolkitStats.h"
+#include "Async/Async.h"
+#include "Containers/Ticker.h"
+
+DECLARE_CYCLE_STAT(TEXT("Create Components"), STAT_PolyCreateComponents, STATGROUP_PolyToolkit);
+
+void UPolyImportSession::Start(UObject* WorldContextObject, const FPolyAsset& Asset, const FPolyFormat& Format, const FPolyImportOptions& Options, const FOnImportAssetProgress& OnImportAssetProgress, const FOnImportAssetComplete& OnImportAssetComplete)
+{
+	this->WorldContextObject = WorldContextObject;
+	this->OnImportAssetProgress = OnImportAssetProgress;
+	this->OnImportAssetComplete = OnImportAssetComplete;
+	ImportedAsset = Asset;
+	ImportedFormat = Format;
+	this->Options = Options;
+
+	// glTF2 models cooked by a previous import need no download at all.
+	TWeakObjectPtr<UPolyImportSession> WeakThis(this);
+	UPolyDiskCache* DiskCache = UPolyToolkit::GetPolyToolkitInstance()->GetDiskCache();
+	if(Format.formatType == "GLTF2" && DiskCache->Map(GetCookedFile(), Asset.updateTime, [WeakThis](TSharedPtr<FPolyMappedFile, ESPMode::ThreadSafe> Mapped)
+	{
+		if(WeakThis.IsValid())
+		{
+			WeakThis->OnCookedModelLoaded(Mapped);
+		}
+	}))
+	{
+		return;
+	}
+	DownloadResources();
+}
+
+void UPolyImportSession::OnCookedModelLoaded(TSharedPtr<FPolyMappedFile, ESPMode::ThreadSafe> Mapped)
+{
+	if(!Mapped.IsValid())
+	{
+		DownloadResources();
+		return;
+	}
+	CookedFile = Mapped;
+	bLoadCookedModel = true;
+	ImportModel();
+}
+
+void UPolyImportSession::DownloadResources()
+{
+	PendingDownloads = ImportedFormat.resources.Num() + 1; // The root plus all the resources.
+	DownloadResource(ImportedFormat.root, EPolyDownloadPriority::Root);
+	for(auto& Resource : ImportedFormat.resources)
+	{
+		DownloadResource(Resource, UPolyDownloadScheduler::GetResourcePriority(Resource));
+	}
+}
+
+void UPolyImportSession::DownloadResource(const FPolyFile& File, EPolyDownloadPriority Priority)
+{
+	UPolyDownloadScheduler* Scheduler = UPolyToolkit::GetPolyToolkitInstance()->GetDownloadScheduler();
+	Scheduler->Enqueue(this, File, ImportedAsset.name, ImportedAsset.updateTime, Options.InMemory, Priority);
+}
+
+void UPolyImportSession::OnDownloadResourceComplete(const FPolyFile& File, bool Status, const FPolySharedContent& Content)
+{
+	// Images are decoded right away, while the other files download.
+	if(Status && ImportedFormat.formatType == "GLTF2" && File.contentType.StartsWith(TEXT("image/")))
+	{
+		UPolyTextureCache* TextureCache = UPolyToolkit::GetPolyToolkitInstance()->GetTextureCache();
+		if(Options.InMemory)
+		{
+			ImageDecodePool.Add(File.relativePath, File.contentType, Content, Options, TextureCache);
+		}
+		else
+		{
+			ImageDecodePool.AddFile(File.relativePath, File.contentType, UHttpDownload::GetResourcePath(ImportedAsset.name, File.relativePath), Options, TextureCache);
+		}
+	}
+
+	if(Options.InMemory && Status)
+	{
+		Resources.Add(File.relativePath, Content);
+	}
+
+	PendingDownloads--;
+	if(PendingDownloads == 0)
+	{
+		// Save the index once for all the files read from the cache.
+		UPolyToolkit::GetPolyToolkitInstance()->GetDiskCache()->Flush();
+		ImportModel();
+	}
+}
+
+FPolyFile UPolyImportSession::GetCookedFile() const
+{
+	// Not a real file, it only names the cooked model in the disk cache.
+	FPolyFile File;
+	File.relativePath = ImportedFormat.root.relativePath;
+	TArray<FString> Flags;
+	if(Options.MergeMeshes)
+	{
+		Flags.Add(TEXT("merged"));
+	}
+	if(Options.CompressTextures)
+	{
+		Flags.Add(TEXT("compressed"));
+	}
+	if(Options.GenerateMips)
+	{
+		Flags.Add(TEXT("mips"));
+	}
+	if(Options.MaxTextureSize > 0)
+	{
+		Flags.Add(FString::Printf(TEXT("max_texture_size=%d"), Options.MaxTextureSize));
+	}
+	File.url = TEXT("cooked:") + ImportedFormat.root.url;
+	if(Flags.Num() > 0)
+	{
+		File.url += TEXT("?") + FString::Join(Flags, TEXT("&"));
+	}
+	return File;
+}
+
+void UPolyImportSession::ImportModel()
+{
+	if (ImportedFormat.formatType == "GLTF2")
+	{
+		Gltf2Importer = NewObject<UGltf2Importer>(this);
+		Gltf2Importer->BeginImport(Options, &ImageDecodePool);
+	}
+	else if(ImportedFormat.formatType == "GLTF")
+	{
+		Gltf1Importer = NewObject<UGltf1Importer>(this);
+		Gltf1Importer->BeginImport(Options);
+	}
+	else
+	{
+		CreateModel(false);
+		return;
+	}
+
+	// Images are decoded on the worker, the module can only be loaded here.
+	FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+
+	// glTF2 models parsed from their files are cooked for the next imports.
+	bCookModel = Gltf2Importer != NULL && !bLoadCookedModel && UPolyToolkit::GetPolyToolkitInstance()->GetDiskCache()->IsEnabled();
+
+	// Parsing and decoding create no UObject and run on the thread pool. The
+	// session is kept alive by the toolkit until the model is created.
+	TWeakObjectPtr<UPolyImportSession> WeakThis(this);
+	Async<void>(EAsyncExecution::ThreadPool, [this, WeakThis]()
+	{
+		bool Parsed = ParseModel();
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, Parsed]()
+		{
+			if(WeakThis.IsValid())
+			{
+				WeakThis->CreateModel(Parsed);
+			}
+		});
+	});
+}
+
+bool UPolyImportSession::ParseModel()
+{
+	if(Gltf2Importer != NULL)
+	{
+		if(bLoadCookedModel)
+		{
+			// Everything is copied out, unmap the file so the cache can delete it.
+			bool Loaded = Gltf2Importer->LoadCookedModel(CookedFile->GetData(), CookedFile->Num());
+			CookedFile.Reset();
+			return Loaded;
+		}
+
+		bool Parsed = Options.InMemory
+			? Gltf2Importer->ParseModelFromMemory(ImportedFormat, Resources)
+			: Gltf2Importer->ParseModel(ImportedFormat, ImportedAsset.name);
+		if(Parsed && bCookModel)
+		{
+			Gltf2Importer->CookModel(CookedModel);
+		}
+		return Parsed;
+	}
+
+	if(Options.InMemory)
+	{
+		return Gltf1Importer->ParseModelFromMemory(ImportedFormat, Resources);
+	}
+	return Gltf1Importer->ParseModel(ImportedFormat, ImportedAsset.name);
+}
+
+void UPolyImportSession::CreateModel(bool Parsed)
+{
+	// Images the model did not use are dropped with the others.
+	ImageDecodePool.Empty();
+
+	if(bLoadCookedModel)
+	{
+		bLoadCookedModel = false;
+		CookedFile.Reset();
+		if(!Parsed)
+		{
+			// The cooked model is outdated, import the original files.
+			Gltf2Importer = NULL;
+			DownloadResources();
+			return;
+		}
+	}
+
+	if(CookedModel.Num() > 0)
+	{
+		UPolyToolkit::GetPolyToolkitInstance()->GetDiskCache()->Store(GetCookedFile(), ImportedAsset.updateTime, MoveTemp(CookedModel));
+		CookedModel.Empty();
+	}
+
+	if(!Parsed)
+	{
+		FPolyActorResponse ActorResponse;
+		ActorResponse.ErrorMessage = "Model could not be imported";
+		ActorResponse.Success = false;
+		Complete(ActorResponse);
+		return;
+	}
+
+	// Textures of previous imports may have been collected since the worker
+	// skipped their images. Those are decoded on the worker too, never here.
+	if(Gltf2Importer != NULL && !Gltf2Importer->ResolveCachedTextures())
+	{
+		TWeakObjectPtr<UPolyImportSession> WeakThis(this);
+		Async<void>(EAsyncExecution::ThreadPool, [this, WeakThis]()
+		{
+			Gltf2Importer->DecodeMissingImages();
+			AsyncTask(ENamedThreads::GameThread, [WeakThis]()
+			{
+				if(WeakThis.IsValid())
+				{
+					WeakThis->CreateModel(true);
+				}
+			});
+		});
+		return;
+	}
+
+	UWorld* World = GEngine->GetWorldFromContextObjectChecked(WorldContextObject);
+	PolyActor = World->SpawnActor<AActor>(AActor::StaticClass());
+	if(Gltf2Importer != NULL)
+	{
+		Gltf2Importer->BeginCreateModel(PolyActor.Get());
+	}
+	else
+	{
+		Gltf1Importer->BeginCreateModel(PolyActor.Get());
+	}
+
+	// Spend this frame's budget right away, then continue on the next ones.
+	if(TickCreateModel(0.0f))
+	{
+		FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UPolyImportSession::TickCreateModel));
+	}
+}
+
+bool UPolyImportSession::TickCreateModel(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PolyCreateComponents);
+
+	FPolyActorResponse ActorResponse;
+	if(!PolyActor.IsValid())
+	{
+		ActorResponse.ErrorMessage = "Actor was destroyed before the model was imported";
+		ActorResponse.Success = false;
+		Complete(ActorResponse);
+		return false;
+	}
+
+	double EndTime = Options.FrameBudgetMs > 0.0f ? FPlatformTime::Seconds() + Options.FrameBudgetMs / 1000.0 : DBL_MAX;
+	bool Created;
+	float Progress;
+	if(Gltf2Importer != NULL)
+	{
+		Created = Gltf2Importer->CreateComponents(EndTime);
+		Progress = Gltf2Importer->GetCreationProgress();
+	}
+	else
+	{
+		Created = Gltf1Importer->CreateComponents(EndTime);
+		Progress = Gltf1Importer->GetCreationProgress();
+	}
+	OnImportAssetProgress.ExecuteIfBound(Progress);
+
+	if(!Created)
+	{
+		return true;
+	}
+
+	ActorResponse.Actor = PolyActor.Get();
+	ActorResponse.Success = true;
+	Complete(ActorResponse);
+	return false;
+}
+
+void UPolyImportSession::Complete(const FPolyActorResponse& ActorResponse)
+{
+	// The session is done, release it before handing control back to the caller
+	// so the callback is free to start a new import.
+	Resources.Empty();
+	ImageDecodePool.Empty();
+	Gltf1Importer = NULL;
+	Gltf2Importer = NULL;
+	PolyActor = NULL;
+	UPolyToolkit::GetPolyToolkitInstance()->OnImportSessionComplete(this);
+	OnImportAssetComplete.ExecuteIfBound(ActorResponse);
+}
@@ -0,0 +1,116 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PolyAsset.h"
+#include "PolyDownloadScheduler.h"
+#include "PolyImageDecodePool.h"
+#include "PolyImportOptions.h"
+#include "PolyToolkit.h"
+
+#include "PolyImportSession.generated.h"
+
+class UGltf1Importer;
+class UGltf2Importer;
+
+/**
+ * State of a single ImportAsset call. Every call gets its own session so
+ * several imports can download and load at the same time. Once downloaded
+ * the model is parsed on a worker thread, only its components are created
+ * on the game thread. glTF2 models are cooked into the disk cache, importing
+ * them again skips the downloads and the parsing.
+ */
+UCLASS()
+class UPolyImportSession : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * Downloads the root and all the resources of Format. When every download
+	 * is completed the model is imported and OnImportAssetComplete is executed.
+	 * OnImportAssetProgress is executed every frame the model is being created.
+	 */
+	void Start(UObject* WorldContextObject, const FPolyAsset& Asset, const FPolyFormat& Format, const FPolyImportOptions& Options, const FOnImportAssetProgress& OnImportAssetProgress, const FOnImportAssetComplete& OnImportAssetComplete);
+
+	/**
+	 * Called by the download scheduler when one of the files of this session
+	 * is done. Content holds the file if it was kept in memory.
+	 */
+	void OnDownloadResourceComplete(const FPolyFile& File, bool Status, const FPolySharedContent& Content);
+
+private:
+	void DownloadResources();
+	void DownloadResource(const FPolyFile& File, EPolyDownloadPriority Priority);
+	void OnCookedModelLoaded(TSharedPtr<FPolyMappedFile, ESPMode::ThreadSafe> Mapped);
+	void ImportModel();
+
+	// Names the cooked model of the asset in the disk cache.
+	FPolyFile GetCookedFile() const;
+
+	// Runs on a worker thread.
+	bool ParseModel();
+
+	// Back on the game thread, Parsed tells if ParseModel succeeded.
+	void CreateModel(bool Parsed);
+
+	// Creates components within the frame budget, returns true while there
+	// are some left.
+	bool TickCreateModel(float DeltaTime);
+
+	void Complete(const FPolyActorResponse& ActorResponse);
+
+	FOnImportAssetProgress OnImportAssetProgress;
+	FOnImportAssetComplete OnImportAssetComplete;
+
+	UPROPERTY()
+	UObject* WorldContextObject;
+
+	FPolyAsset ImportedAsset;
+	FPolyFormat ImportedFormat;
+	FPolyImportOptions Options;
+	int32 PendingDownloads;
+
+	// Contents of the downloaded files by relative path, only used when
+	// importing in memory.
+	TMap<FString, FPolySharedContent> Resources;
+
+	// Images of the downloaded files, decoded before the model is parsed.
+	FPolyImageDecodePool ImageDecodePool;
+
+	// True if the model is read from CookedFile instead of the downloaded
+	// files, see UGltf2Importer::LoadCookedModel.
+	bool bLoadCookedModel;
+
+	// True if the worker writes the model to CookedModel, stored in the disk
+	// cache once back on the game thread.
+	bool bCookModel;
+
+	// Cooked model written to the disk cache.
+	TArray<uint8> CookedModel;
+
+	// Cooked model of a previous import, mapped from the disk cache.
+	TSharedPtr<FPolyMappedFile, ESPMode::ThreadSafe> CookedFile;
+
+	// Importer of the model, depending on its format.
+	UPROPERTY()
+	UGltf1Importer* Gltf1Importer;
+	UPROPERTY()
+	UGltf2Importer* Gltf2Importer;
+
+	// Actor being built, the import fails if it is destroyed before the end.
+	TWeakObjectPtr<AActor> PolyActor;
+};
@@ -0,0 +1,418 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "CoreMinimal.h"
+#include "PolyJsonReader.h"
+
+#define MAX_JSON_DEPTH 64
+
+FPolyJsonReader::FPolyJsonReader(const uint8* Data, int32 Size)
+{
+	Cursor = reinterpret_cast<const ANSICHAR*>(Data);
+	End = Cursor + Size;
+	Depth = 0;
+	bError = false;
+
+	// Skip a byte order mark.
+	if(Size >= 3 && Data[0] == 0xEF && Data[1] == 0xBB && Data[2] == 0xBF)
+	{
+		Cursor += 3;
+	}
+}
+
+bool FPolyJsonReader::ReadObject(TFunctionRef<bool(const FPolyJsonKey& Key)> OnField)
+{
+	if(!Expect('{') || ++Depth > MAX_JSON_DEPTH)
+	{
+		return Fail();
+	}
+
+	SkipWhitespace();
+	if(Cursor < End && *Cursor == '}')
+	{
+		Cursor++;
+		Depth--;
+		return true;
+	}
+
+	while(true)
+	{
+		FPolyJsonKey Key;
+		bool bEscaped;
+		if(!ReadStringToken(Key.Data, Key.Length, bEscaped) || !Expect(':') || !OnField(Key) || bError)
+		{
+			return Fail();
+		}
+
+		SkipWhitespace();
+		if(Cursor < End && *Cursor == ',')
+		{
+			Cursor++;
+			continue;
+		}
+		if(!Expect('}'))
+		{
+			return Fail();
+		}
+		Depth--;
+		return true;
+	}
+}
+
+bool FPolyJsonReader::ReadArray(TFunctionRef<bool()> OnElement)
+{
+	if(!Expect('[') || ++Depth > MAX_JSON_DEPTH)
+	{
+		return Fail();
+	}
+
+	SkipWhitespace();
+	if(Cursor < End && *Cursor == ']')
+	{
+		Cursor++;
+		Depth--;
+		return true;
+	}
+
+	while(true)
+	{
+		if(!OnElement() || bError)
+		{
+			return Fail();
+		}
+
+		SkipWhitespace();
+		if(Cursor < End && *Cursor == ',')
+		{
+			Cursor++;
+			continue;
+		}
+		if(!Expect(']'))
+		{
+			return Fail();
+		}
+		Depth--;
+		return true;
+	}
+}
+
+// Appends Code as UTF-8.
+static void AppendUtf8(TArray<ANSICHAR>& Text, uint32 Code)
+{
+	if(Code < 0x80)
+	{
+		Text.Add(static_cast<ANSICHAR>(Code));
+	}
+	else if(Code < 0x800)
+	{
+		Text.Add(static_cast<ANSICHAR>(0xC0 | (Code >> 6)));
+		Text.Add(static_cast<ANSICHAR>(0x80 | (Code & 0x3F)));
+	}
+	else if(Code < 0x10000)
+	{
+		Text.Add(static_cast<ANSICHAR>(0xE0 | (Code >> 12)));
+		Text.Add(static_cast<ANSICHAR>(0x80 | ((Code >> 6) & 0x3F)));
+		Text.Add(static_cast<ANSICHAR>(0x80 | (Code & 0x3F)));
+	}
+	else
+	{
+		Text.Add(static_cast<ANSICHAR>(0xF0 | (Code >> 18)));
+		Text.Add(static_cast<ANSICHAR>(0x80 | ((Code >> 12) & 0x3F)));
+		Text.Add(static_cast<ANSICHAR>(0x80 | ((Code >> 6) & 0x3F)));
+		Text.Add(static_cast<ANSICHAR>(0x80 | (Code & 0x3F)));
+	}
+}
+
+// Reads the 4 hex digits of a \u escape.
+static bool ParseHex4(const ANSICHAR* Digits, uint32& Code)
+{
+	Code = 0;
+	for(int32 i = 0; i < 4; i++)
+	{
+		ANSICHAR Char = Digits[i];
+		uint32 Digit;
+		if(Char >= '0' && Char <= '9')
+		{
+			Digit = Char - '0';
+		}
+		else if(Char >= 'a' && Char <= 'f')
+		{
+			Digit = Char - 'a' + 10;
+		}
+		else if(Char >= 'A' && Char <= 'F')
+		{
+			Digit = Char - 'A' + 10;
+		}
+		else
+		{
+			return false;
+		}
+		Code = (Code << 4) | Digit;
+	}
+	return true;
+}
+
+bool FPolyJsonReader::ReadString(FString& Value)
+{
+	SkipWhitespace();
+	if(Cursor < End && *Cursor == 'n')
+	{
+		Value.Empty();
+		return ExpectLiteral("null");
+	}
+
+	const ANSICHAR* Start;
+	int32 Length;
+	bool bEscaped;
+	if(!ReadStringToken(Start, Length, bEscaped))
+	{
+		return false;
+	}
+
+	// Most strings have no escape and are converted in place.
+	if(!bEscaped)
+	{
+		FUTF8ToTCHAR Converted(Start, Length);
+		Value = FString(Converted.Length(), Converted.Get());
+		return true;
+	}
+
+	TArray<ANSICHAR> Text;
+	Text.Reserve(Length);
+	for(const ANSICHAR* Char = Start; Char < Start + Length; Char++)
+	{
+		if(*Char != '\\')
+		{
+			Text.Add(*Char);
+			continue;
+		}
+
+		// ReadStringToken made sure an escape is followed by a character.
+		Char++;
+		switch(*Char)
+		{
+			case 'b': Text.Add('\b'); break;
+			case 'f': Text.Add('\f'); break;
+			case 'n': Text.Add('\n'); break;
+			case 'r': Text.Add('\r'); break;
+			case 't': Text.Add('\t'); break;
+			case 'u':
+			{
+				uint32 Code;
+				if(Start + Length - Char < 5 || !ParseHex4(Char + 1, Code))
+				{
+					return Fail();
+				}
+				Char += 4;
+
+				// Characters outside the BMP are escaped as a surrogate pair.
+				uint32 Low;
+				if(Code >= 0xD800 && Code < 0xDC00 && Start + Length - Char >= 7
+					&& Char[1] == '\\' && Char[2] == 'u' && ParseHex4(Char + 3, Low) && Low >= 0xDC00 && Low < 0xE000)
+				{
+					Code = 0x10000 + ((Code - 0xD800) << 10) + (Low - 0xDC00);
+					Char += 6;
+				}
+				AppendUtf8(Text, Code);
+				break;
+			}
+			default:
+				Text.Add(*Char);
+				break;
+		}
+	}
+
+	FUTF8ToTCHAR Converted(Text.GetData(), Text.Num());
+	Value = FString(Converted.Length(), Converted.Get());
+	return true;
+}
+
+bool FPolyJsonReader::ReadInt64(int64& Value)
+{
+	SkipWhitespace();
+	const ANSICHAR* Start;
+	int32 Length;
+	bool bEscaped;
+	if(Cursor < End && *Cursor == '"')
+	{
+		if(!ReadStringToken(Start, Length, bEscaped))
+		{
+			return false;
+		}
+	}
+	else if(!ReadNumberToken(Start, Length))
+	{
+		return false;
+	}
+
+	// Numbers are short, copy them to terminate them.
+	ANSICHAR Number[64];
+	if(Length >= ARRAY_COUNT(Number))
+	{
+		return Fail();
+	}
+	FMemory::Memcpy(Number, Start, Length);
+	Number[Length] = 0;
+
+	bool bInteger = true;
+	for(int32 i = 0; i < Length; i++)
+	{
+		if(Number[i] == '.' || Number[i] == 'e' || Number[i] == 'E')
+		{
+			bInteger = false;
+		}
+	}
+	Value = bInteger ? FCStringAnsi::Atoi64(Number) : static_cast<int64>(FCStringAnsi::Atod(Number));
+	return true;
+}
+
+bool FPolyJsonReader::ReadInt32(int32& Value)
+{
+	int64 Value64;
+	if(!ReadInt64(Value64))
+	{
+		return false;
+	}
+	Value = static_cast<int32>(FMath::Clamp<int64>(Value64, MIN_int32, MAX_int32));
+	return true;
+}
+
+bool FPolyJsonReader::ReadBool(bool& Value)
+{
+	SkipWhitespace();
+	if(Cursor < End && *Cursor == 't')
+	{
+		Value = true;
+		return ExpectLiteral("true");
+	}
+	Value = false;
+	return ExpectLiteral("false");
+}
+
+bool FPolyJsonReader::SkipValue()
+{
+	SkipWhitespace();
+	if(Cursor >= End)
+	{
+		return Fail();
+	}
+
+	const ANSICHAR* Start;
+	int32 Length;
+	bool bEscaped;
+	switch(*Cursor)
+	{
+		case '{':
+			return ReadObject([this](const FPolyJsonKey& Key) { return SkipValue(); });
+		case '[':
+			return ReadArray([this]() { return SkipValue(); });
+		case '"':
+			return ReadStringToken(Start, Length, bEscaped);
+		case 't':
+			return ExpectLiteral("true");
+		case 'f':
+			return ExpectLiteral("false");
+		case 'n':
+			return ExpectLiteral("null");
+		default:
+			return ReadNumberToken(Start, Length);
+	}
+}
+
+bool FPolyJsonReader::IsAtEnd()
+{
+	SkipWhitespace();
+	return !bError && Cursor == End;
+}
+
+void FPolyJsonReader::SkipWhitespace()
+{
+	while(Cursor < End && (*Cursor == ' ' || *Cursor == '\t' || *Cursor == '\n' || *Cursor == '\r'))
+	{
+		Cursor++;
+	}
+}
+
+bool FPolyJsonReader::Expect(ANSICHAR Char)
+{
+	SkipWhitespace();
+	if(bError || Cursor >= End || *Cursor != Char)
+	{
+		return Fail();
+	}
+	Cursor++;
+	return true;
+}
+
+bool FPolyJsonReader::ExpectLiteral(const ANSICHAR* Literal)
+{
+	int32 Length = FCStringAnsi::Strlen(Literal);
+	if(bError || End - Cursor < Length || FMemory::Memcmp(Cursor, Literal, Length) != 0)
+	{
+		return Fail();
+	}
+	Cursor += Length;
+	return true;
+}
+
+bool FPolyJsonReader::ReadStringToken(const ANSICHAR*& Start, int32& Length, bool& bEscaped)
+{
+	if(!Expect('"'))
+	{
+		return false;
+	}
+
+	Start = Cursor;
+	bEscaped = false;
+	while(Cursor < End && *Cursor != '"')
+	{
+		if(*Cursor == '\\')
+		{
+			// Skip the escaped character, it may be a quote.
+			bEscaped = true;
+			if(++Cursor >= End)
+			{
+				break;
+			}
+		}
+		Cursor++;
+	}
+	if(Cursor >= End)
+	{
+		return Fail();
+	}
+
+	Length = Cursor - Start;
+	Cursor++;
+	return true;
+}
+
+bool FPolyJsonReader::ReadNumberToken(const ANSICHAR*& Start, int32& Length)
+{
+	SkipWhitespace();
+	Start = Cursor;
+	while(Cursor < End && ((*Cursor >= '0' && *Cursor <= '9') || *Cursor == '-' || *Cursor == '+' || *Cursor == '.' || *Cursor == 'e' || *Cursor == 'E'))
+	{
+		Cursor++;
+	}
+	Length = Cursor - Start;
+	return Length > 0 || Fail();
+}
+
+bool FPolyJsonReader::Fail()
+{
+	bError = true;
+	return false;
+}
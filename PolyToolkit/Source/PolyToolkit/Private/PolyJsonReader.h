@@ -0,0 +1,85 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Key of an object field, pointing into the JSON text. Keys are compared
+ * as written, escaped characters are not decoded.
+ */
+struct FPolyJsonKey
+{
+	const ANSICHAR* Data;
+	int32 Length;
+
+	bool operator==(const ANSICHAR* Literal) const
+	{
+		return FCStringAnsi::Strlen(Literal) == Length && FMemory::Memcmp(Data, Literal, Length) == 0;
+	}
+};
+
+/**
+ * Pull reader for UTF-8 JSON, reading values straight into the fields they
+ * belong to without building a document first. Every Read function returns
+ * false on malformed input, after which the reader stays in error.
+ */
+class FPolyJsonReader
+{
+public:
+	FPolyJsonReader(const uint8* Data, int32 Size);
+
+	/**
+	 * Reads an object, calling OnField for each of its fields with the
+	 * reader on the value. OnField must read or skip the value.
+	 */
+	bool ReadObject(TFunctionRef<bool(const FPolyJsonKey& Key)> OnField);
+
+	/** Reads an array, calling OnElement with the reader on each element. */
+	bool ReadArray(TFunctionRef<bool()> OnElement);
+
+	/** Reads a string, null reads as an empty string. */
+	bool ReadString(FString& Value);
+
+	/** Reads a number, or a string holding one as Poly does for 64 bit integers. */
+	bool ReadInt64(int64& Value);
+	bool ReadInt32(int32& Value);
+
+	bool ReadBool(bool& Value);
+
+	/** Skips the value of a field the caller does not need. */
+	bool SkipValue();
+
+	/** True once the whole text was read, with nothing but whitespace left. */
+	bool IsAtEnd();
+
+private:
+	void SkipWhitespace();
+	bool Expect(ANSICHAR Char);
+	bool ExpectLiteral(const ANSICHAR* Literal);
+	bool ReadStringToken(const ANSICHAR*& Start, int32& Length, bool& bEscaped);
+	bool ReadNumberToken(const ANSICHAR*& Start, int32& Length);
+	bool Fail();
+
+	const ANSICHAR* Cursor;
+	const ANSICHAR* End;
+
+	// Nested objects and arrays being read, limited so malformed input
+	// cannot overflow the stack.
+	int32 Depth;
+
+	bool bError;
+};
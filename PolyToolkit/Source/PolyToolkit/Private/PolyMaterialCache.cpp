@@ -0,0 +1,41 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CoreMinimal.h"
+#include "PolyMaterialCache.h"
+#include "Materials/MaterialInstanceDynamic.h"
+
+UPolyMaterialCache::UPolyMaterialCache(const class FObjectInitializer& PCIP) : Super(PCIP)
+{
+}
+
+UMaterialInstanceDynamic* UPolyMaterialCache::Find(const FPolyMaterialKey& Key) const
+{
+	UMaterialInstanceDynamic* const* MaterialInstance = InstancesByKey.Find(Key);
+	return MaterialInstance != NULL ? *MaterialInstance : NULL;
+}
+
+UMaterialInstanceDynamic* UPolyMaterialCache::Create(const FPolyMaterialKey& Key)
+{
+	UMaterialInstanceDynamic* MaterialInstance = UMaterialInstanceDynamic::Create(Key.Parent, this);
+	InstancesByKey.Add(Key, MaterialInstance);
+	Instances.Add(MaterialInstance);
+	return MaterialInstance;
+}
+
+void UPolyMaterialCache::Empty()
+{
+	InstancesByKey.Empty();
+	Instances.Empty();
+}
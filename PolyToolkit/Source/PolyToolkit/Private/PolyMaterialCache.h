@@ -0,0 +1,83 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "PolyMaterialCache.generated.h"
+
+class UMaterialInstanceDynamic;
+class UMaterialInterface;
+class UTexture;
+
+/**
+ * Everything that makes a material instance different from another one: its
+ * parent and the values of its parameters, in a fixed order chosen by the
+ * importer that creates it.
+ */
+struct FPolyMaterialKey
+{
+	UMaterialInterface* Parent = NULL;
+	TArray<float> Parameters;
+	TArray<UTexture*> Textures;
+	bool TwoSided = false;
+
+	bool operator==(const FPolyMaterialKey& Other) const
+	{
+		return Parent == Other.Parent && TwoSided == Other.TwoSided && Parameters == Other.Parameters && Textures == Other.Textures;
+	}
+
+	friend uint32 GetTypeHash(const FPolyMaterialKey& Key)
+	{
+		uint32 Hash = HashCombine(PointerHash(Key.Parent), GetTypeHash(Key.TwoSided));
+		Hash = HashCombine(Hash, FCrc::MemCrc32(Key.Parameters.GetData(), Key.Parameters.Num() * sizeof(float)));
+		for(UTexture* Texture : Key.Textures)
+		{
+			Hash = HashCombine(Hash, PointerHash(Texture));
+		}
+		return Hash;
+	}
+};
+
+/**
+ * Material instances shared by every import that sets
+ * FPolyImportOptions::ShareMaterials. The instances are owned by the cache
+ * and live until it is cleared, whatever the actors using them.
+ */
+UCLASS()
+class UPolyMaterialCache : public UObject
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	/** Returns the instance created for Key, NULL if there is none yet. */
+	UMaterialInstanceDynamic* Find(const FPolyMaterialKey& Key) const;
+
+	/** Creates an instance of Key.Parent owned by the cache and remembers it for Key. */
+	UMaterialInstanceDynamic* Create(const FPolyMaterialKey& Key);
+
+	/** Forgets every instance, the actors using them keep them alive. */
+	void Empty();
+
+	/** Number of instances in the cache. */
+	int32 Num() const { return Instances.Num(); }
+
+private:
+	TMap<FPolyMaterialKey, UMaterialInstanceDynamic*> InstancesByKey;
+
+	// Keeps the instances referenced by InstancesByKey alive.
+	UPROPERTY()
+	TArray<UMaterialInstanceDynamic*> Instances;
+};
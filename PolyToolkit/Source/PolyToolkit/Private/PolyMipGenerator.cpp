@@ -0,0 +1,134 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CoreMinimal.h"
+#include "PolyMipGenerator.h"
+#include "Async/ParallelFor.h"
+
+// Mips with fewer pixels than this are filtered on the calling thread.
+#define MIP_PARALLEL_MIN_PIXELS 16384
+
+// Precision of linear colors converted back to sRGB.
+#define LINEAR_TO_SRGB_STEPS 4096
+
+// Lookup tables for both ways of the sRGB transfer function, built once.
+struct FSRGBTables
+{
+	float ToLinear[256];
+	uint8 ToSRGB[LINEAR_TO_SRGB_STEPS];
+
+	FSRGBTables()
+	{
+		for(int32 i = 0; i < 256; i++)
+		{
+			float Value = i / 255.0f;
+			ToLinear[i] = Value <= 0.04045f ? Value / 12.92f : FMath::Pow((Value + 0.055f) / 1.055f, 2.4f);
+		}
+		for(int32 i = 0; i < LINEAR_TO_SRGB_STEPS; i++)
+		{
+			float Value = i / static_cast<float>(LINEAR_TO_SRGB_STEPS - 1);
+			Value = Value <= 0.0031308f ? Value * 12.92f : 1.055f * FMath::Pow(Value, 1.0f / 2.4f) - 0.055f;
+			ToSRGB[i] = static_cast<uint8>(FMath::Clamp(FMath::RoundToInt(Value * 255.0f), 0, 255));
+		}
+	}
+};
+
+static const FSRGBTables& GetSRGBTables()
+{
+	static FSRGBTables Tables;
+	return Tables;
+}
+
+// Averages a row of 2x2 blocks of sRGB pixels in linear space. The pixels
+// are converted by table lookups, their sum is one register scaled back by a
+// single multiply and converted by the other table.
+static void DownsampleRow(const uint8* Row0, const uint8* Row1, int32 Width, int32 MipWidth, uint8* Out)
+{
+	const FSRGBTables& Tables = GetSRGBTables();
+	const float* ToLinear = Tables.ToLinear;
+	const float ColorScale = 0.25f * (LINEAR_TO_SRGB_STEPS - 1);
+	const VectorRegister Scale = MakeVectorRegister(ColorScale, ColorScale, ColorScale, 0.25f);
+	const VectorRegister Half = MakeVectorRegister(0.5f, 0.5f, 0.5f, 0.5f);
+
+	for(int32 x = 0; x < MipWidth; x++, Out += 4)
+	{
+		const uint8* P0 = Row0 + FMath::Min(x * 2, Width - 1) * 4;
+		const uint8* P1 = Row0 + FMath::Min(x * 2 + 1, Width - 1) * 4;
+		const uint8* P2 = Row1 + FMath::Min(x * 2, Width - 1) * 4;
+		const uint8* P3 = Row1 + FMath::Min(x * 2 + 1, Width - 1) * 4;
+
+		// Alpha stays in 0-255, it is linear already.
+		VectorRegister Sum = VectorAdd(
+			VectorAdd(
+				MakeVectorRegister(ToLinear[P0[0]], ToLinear[P0[1]], ToLinear[P0[2]], static_cast<float>(P0[3])),
+				MakeVectorRegister(ToLinear[P1[0]], ToLinear[P1[1]], ToLinear[P1[2]], static_cast<float>(P1[3]))),
+			VectorAdd(
+				MakeVectorRegister(ToLinear[P2[0]], ToLinear[P2[1]], ToLinear[P2[2]], static_cast<float>(P2[3])),
+				MakeVectorRegister(ToLinear[P3[0]], ToLinear[P3[1]], ToLinear[P3[2]], static_cast<float>(P3[3]))));
+
+		float Average[4];
+		VectorStore(VectorMultiplyAdd(Sum, Scale, Half), Average);
+		Out[0] = Tables.ToSRGB[static_cast<int32>(Average[0])];
+		Out[1] = Tables.ToSRGB[static_cast<int32>(Average[1])];
+		Out[2] = Tables.ToSRGB[static_cast<int32>(Average[2])];
+		Out[3] = static_cast<uint8>(Average[3]);
+	}
+}
+
+void FPolyMipGenerator::Downsample(const uint8* BGRA, int32 Width, int32 Height, FPolyMip& Mip)
+{
+	Mip.Width = FMath::Max(1, Width / 2);
+	Mip.Height = FMath::Max(1, Height / 2);
+	Mip.Data.SetNumUninitialized(Mip.Width * Mip.Height * 4);
+
+	// Rows are independent.
+	int32 MipWidth = Mip.Width;
+	uint8* Data = Mip.Data.GetData();
+	ParallelFor(Mip.Height, [BGRA, Width, Height, MipWidth, Data](int32 y)
+	{
+		const uint8* Row0 = BGRA + FMath::Min(y * 2, Height - 1) * Width * 4;
+		const uint8* Row1 = BGRA + FMath::Min(y * 2 + 1, Height - 1) * Width * 4;
+		DownsampleRow(Row0, Row1, Width, MipWidth, Data + y * MipWidth * 4);
+	}, Mip.Width * Mip.Height < MIP_PARALLEL_MIN_PIXELS);
+}
+
+void FPolyMipGenerator::Fit(TArray<uint8>& BGRA, int32& Width, int32& Height, int32 MaxSize)
+{
+	if(MaxSize <= 0)
+	{
+		return;
+	}
+	while(Width > MaxSize || Height > MaxSize)
+	{
+		FPolyMip Mip;
+		Downsample(BGRA.GetData(), Width, Height, Mip);
+		BGRA = MoveTemp(Mip.Data);
+		Width = Mip.Width;
+		Height = Mip.Height;
+	}
+}
+
+void FPolyMipGenerator::Generate(const uint8* BGRA, int32 Width, int32 Height, TArray<FPolyMip>& Mips)
+{
+	// Mips are not moved while they are filtered from one another.
+	Mips.Reserve(Mips.Num() + FMath::FloorLog2(FMath::Max(Width, Height)));
+	while(Width > 1 || Height > 1)
+	{
+		FPolyMip& Mip = Mips[Mips.AddDefaulted()];
+		Downsample(BGRA, Width, Height, Mip);
+		BGRA = Mip.Data.GetData();
+		Width = Mip.Width;
+		Height = Mip.Height;
+	}
+}
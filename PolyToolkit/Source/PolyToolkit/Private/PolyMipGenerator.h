@@ -0,0 +1,49 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * One level of a mip chain. BGRA pixels, or blocks once compressed by
+ * FPolyTextureCompressor.
+ */
+struct FPolyMip
+{
+	int32 Width = 0;
+	int32 Height = 0;
+	TArray<uint8> Data;
+};
+
+/**
+ * Builds the mips of decoded images with a 2x2 box filter, on any thread.
+ * Images are sRGB, their color channels are averaged in linear space so the
+ * mips do not darken. Alpha is linear already.
+ */
+class FPolyMipGenerator
+{
+public:
+	/** Halves a BGRA image, odd sizes drop their last row or column. */
+	static void Downsample(const uint8* BGRA, int32 Width, int32 Height, FPolyMip& Mip);
+
+	/**
+	 * Replaces a BGRA image by its largest mip no wider nor taller than
+	 * MaxSize. 0 keeps the image as is.
+	 */
+	static void Fit(TArray<uint8>& BGRA, int32& Width, int32& Height, int32 MaxSize);
+
+	/** Appends the mips of a BGRA image to Mips down to 1x1, largest first. */
+	static void Generate(const uint8* BGRA, int32 Width, int32 Height, TArray<FPolyMip>& Mips);
+};
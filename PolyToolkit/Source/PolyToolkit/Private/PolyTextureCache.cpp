@@ -0,0 +1,104 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CoreMinimal.h"
+#include "PolyTextureCache.h"
+#include "Engine/Texture2D.h"
+#include "UObject/UObjectGlobals.h"
+
+UPolyTextureCache::UPolyTextureCache(const class FObjectInitializer& PCIP) : Super(PCIP)
+{
+}
+
+void UPolyTextureCache::PostInitProperties()
+{
+	Super::PostInitProperties();
+	if(!HasAnyFlags(RF_ClassDefaultObject))
+	{
+		PostGarbageCollectHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &UPolyTextureCache::RemoveStaleTextures);
+	}
+}
+
+void UPolyTextureCache::BeginDestroy()
+{
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGarbageCollectHandle);
+	Super::BeginDestroy();
+}
+
+FSHAHash UPolyTextureCache::HashImage(const uint8* RawFileData, int32 RawFileSize, const FPolyImportOptions& Options)
+{
+	// Only the options that change the texture, with a fixed layout.
+	uint8 Flags = (Options.CompressTextures ? 1 : 0) | (Options.GenerateMips ? 2 : 0);
+	int32 MaxTextureSize = FMath::Max(Options.MaxTextureSize, 0);
+	uint8 MaxTextureSizeBytes[4] =
+	{
+		static_cast<uint8>(MaxTextureSize),
+		static_cast<uint8>(MaxTextureSize >> 8),
+		static_cast<uint8>(MaxTextureSize >> 16),
+		static_cast<uint8>(MaxTextureSize >> 24)
+	};
+
+	FSHA1 Sha;
+	Sha.Update(RawFileData, RawFileSize);
+	Sha.Update(&Flags, sizeof(Flags));
+	Sha.Update(MaxTextureSizeBytes, sizeof(MaxTextureSizeBytes));
+	Sha.Final();
+
+	FSHAHash Hash;
+	Sha.GetHash(Hash.Hash);
+	return Hash;
+}
+
+bool UPolyTextureCache::Contains(const FSHAHash& Hash) const
+{
+	FScopeLock Lock(&TexturesLock);
+	const TWeakObjectPtr<UTexture2D>* Texture = Textures.Find(Hash);
+	return Texture != NULL && Texture->IsValid();
+}
+
+UTexture2D* UPolyTextureCache::Find(const FSHAHash& Hash)
+{
+	check(IsInGameThread());
+	FScopeLock Lock(&TexturesLock);
+	TWeakObjectPtr<UTexture2D>* Texture = Textures.Find(Hash);
+	if(Texture == NULL)
+	{
+		return NULL;
+	}
+	if(!Texture->IsValid())
+	{
+		Textures.Remove(Hash);
+		return NULL;
+	}
+	return Texture->Get();
+}
+
+void UPolyTextureCache::Add(const FSHAHash& Hash, UTexture2D* Texture)
+{
+	check(IsInGameThread());
+	FScopeLock Lock(&TexturesLock);
+	Textures.Add(Hash, Texture);
+}
+
+void UPolyTextureCache::RemoveStaleTextures()
+{
+	FScopeLock Lock(&TexturesLock);
+	for(auto It = Textures.CreateIterator(); It; ++It)
+	{
+		if(!It.Value().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
@@ -0,0 +1,72 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/SecureHash.h"
+#include "PolyImportOptions.h"
+
+#include "PolyTextureCache.generated.h"
+
+class UTexture2D;
+
+/**
+ * Textures decoded by previous imports, by hash of their compressed image
+ * and of the import options that change the texture made from it. The cache does not keep them alive: a texture lives as long as a material
+ * uses it and is decoded again once every model using it is gone. Entries of
+ * collected textures are removed after every garbage collection. Contains
+ * can be called from any thread, everything else from the game thread.
+ */
+UCLASS()
+class UPolyTextureCache : public UObject
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	/**
+	 * Hashes the compressed image a texture is decoded from, along with the
+	 * Options it is imported with: the same image makes another texture
+	 * once compressed, without mips or reduced to a maximum size.
+	 */
+	static FSHAHash HashImage(const uint8* RawFileData, int32 RawFileSize, const FPolyImportOptions& Options);
+
+	/**
+	 * True if a live texture was decoded from the image with Hash. It may be
+	 * collected by the time the caller gets to the game thread, Find tells
+	 * for sure.
+	 */
+	bool Contains(const FSHAHash& Hash) const;
+
+	/** Returns the live texture decoded from the image with Hash, NULL if there is none. */
+	UTexture2D* Find(const FSHAHash& Hash);
+
+	/** Remembers Texture as decoded from the image with Hash. */
+	void Add(const FSHAHash& Hash, UTexture2D* Texture);
+
+	virtual void PostInitProperties() override;
+	virtual void BeginDestroy() override;
+
+private:
+	// Forgets the textures that have been garbage collected.
+	void RemoveStaleTextures();
+
+	TMap<FSHAHash, TWeakObjectPtr<UTexture2D>> Textures;
+
+	// Guards Textures against the imports decoding on worker threads.
+	mutable FCriticalSection TexturesLock;
+
+	FDelegateHandle PostGarbageCollectHandle;
+};
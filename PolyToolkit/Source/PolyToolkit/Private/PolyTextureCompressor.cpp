@@ -0,0 +1,292 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CoreMinimal.h"
+#include "PolyTextureCompressor.h"
+#include "Async/ParallelFor.h"
+
+// Mips with fewer blocks than this are compressed on the calling thread.
+#define COMPRESS_PARALLEL_MIN_BLOCKS 1024
+
+static FORCEINLINE uint16 PackRGB565(int32 R, int32 G, int32 B)
+{
+	return static_cast<uint16>((((R * 31 + 127) / 255) << 11) | (((G * 63 + 127) / 255) << 5) | ((B * 31 + 127) / 255));
+}
+
+static FORCEINLINE void UnpackRGB565(uint16 Color, int32* RGB)
+{
+	int32 R = (Color >> 11) & 31;
+	int32 G = (Color >> 5) & 63;
+	int32 B = Color & 31;
+	RGB[0] = (R << 3) | (R >> 2);
+	RGB[1] = (G << 2) | (G >> 4);
+	RGB[2] = (B << 3) | (B >> 2);
+}
+
+// Copies the 4x4 block at BlockX, BlockY of a BGRA image. Blocks past the
+// edges of the image repeat its last row and column.
+static void GatherBlock(const uint8* BGRA, int32 Width, int32 Height, int32 BlockX, int32 BlockY, uint8* Block)
+{
+	for(int32 y = 0; y < 4; y++)
+	{
+		int32 SourceY = FMath::Min(BlockY * 4 + y, Height - 1);
+		for(int32 x = 0; x < 4; x++)
+		{
+			int32 SourceX = FMath::Min(BlockX * 4 + x, Width - 1);
+			FMemory::Memcpy(Block + (y * 4 + x) * 4, BGRA + (SourceY * Width + SourceX) * 4, 4);
+		}
+	}
+}
+
+// Color part of a BC1 or BC3 block, always in its four colors mode.
+static void EncodeColorBlock(const uint8* Block, uint8* Out)
+{
+	// The endpoints are the two colors furthest apart along the principal
+	// axis of the block, found by power iteration on the covariance.
+	float Mean[3] = { 0.0f, 0.0f, 0.0f };
+	for(int32 i = 0; i < 16; i++)
+	{
+		Mean[0] += Block[i * 4 + 2];
+		Mean[1] += Block[i * 4 + 1];
+		Mean[2] += Block[i * 4 + 0];
+	}
+	for(float& Channel : Mean)
+	{
+		Channel /= 16.0f;
+	}
+
+	float Covariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+	for(int32 i = 0; i < 16; i++)
+	{
+		float R = Block[i * 4 + 2] - Mean[0];
+		float G = Block[i * 4 + 1] - Mean[1];
+		float B = Block[i * 4 + 0] - Mean[2];
+		Covariance[0] += R * R;
+		Covariance[1] += R * G;
+		Covariance[2] += R * B;
+		Covariance[3] += G * G;
+		Covariance[4] += G * B;
+		Covariance[5] += B * B;
+	}
+
+	float Axis[3] = { 1.0f, 1.0f, 1.0f };
+	for(int32 Iteration = 0; Iteration < 4; Iteration++)
+	{
+		float X = Covariance[0] * Axis[0] + Covariance[1] * Axis[1] + Covariance[2] * Axis[2];
+		float Y = Covariance[1] * Axis[0] + Covariance[3] * Axis[1] + Covariance[4] * Axis[2];
+		float Z = Covariance[2] * Axis[0] + Covariance[4] * Axis[1] + Covariance[5] * Axis[2];
+		float Length = FMath::Max3(FMath::Abs(X), FMath::Abs(Y), FMath::Abs(Z));
+		if(Length < KINDA_SMALL_NUMBER)
+		{
+			// A flat block, any axis will do.
+			break;
+		}
+		Axis[0] = X / Length;
+		Axis[1] = Y / Length;
+		Axis[2] = Z / Length;
+	}
+
+	int32 MinPixel = 0;
+	int32 MaxPixel = 0;
+	float MinProjection = FLT_MAX;
+	float MaxProjection = -FLT_MAX;
+	for(int32 i = 0; i < 16; i++)
+	{
+		float Projection = Block[i * 4 + 2] * Axis[0] + Block[i * 4 + 1] * Axis[1] + Block[i * 4 + 0] * Axis[2];
+		if(Projection < MinProjection)
+		{
+			MinProjection = Projection;
+			MinPixel = i;
+		}
+		if(Projection > MaxProjection)
+		{
+			MaxProjection = Projection;
+			MaxPixel = i;
+		}
+	}
+
+	// The first endpoint must be the larger one, smaller means three colors
+	// and transparency to BC1.
+	const uint8* Max = Block + MaxPixel * 4;
+	const uint8* Min = Block + MinPixel * 4;
+	uint16 Color0 = PackRGB565(Max[2], Max[1], Max[0]);
+	uint16 Color1 = PackRGB565(Min[2], Min[1], Min[0]);
+	if(Color0 < Color1)
+	{
+		Swap(Color0, Color1);
+	}
+	Out[0] = static_cast<uint8>(Color0 & 0xFF);
+	Out[1] = static_cast<uint8>(Color0 >> 8);
+	Out[2] = static_cast<uint8>(Color1 & 0xFF);
+	Out[3] = static_cast<uint8>(Color1 >> 8);
+
+	uint32 Indices = 0;
+	if(Color0 != Color1)
+	{
+		int32 Palette[4][3];
+		UnpackRGB565(Color0, Palette[0]);
+		UnpackRGB565(Color1, Palette[1]);
+		for(int32 c = 0; c < 3; c++)
+		{
+			Palette[2][c] = (2 * Palette[0][c] + Palette[1][c]) / 3;
+			Palette[3][c] = (Palette[0][c] + 2 * Palette[1][c]) / 3;
+		}
+
+		for(int32 i = 0; i < 16; i++)
+		{
+			int32 Best = 0;
+			int32 BestDistance = MAX_int32;
+			for(int32 p = 0; p < 4; p++)
+			{
+				int32 R = Block[i * 4 + 2] - Palette[p][0];
+				int32 G = Block[i * 4 + 1] - Palette[p][1];
+				int32 B = Block[i * 4 + 0] - Palette[p][2];
+				int32 Distance = R * R + G * G + B * B;
+				if(Distance < BestDistance)
+				{
+					Best = p;
+					BestDistance = Distance;
+				}
+			}
+			Indices |= static_cast<uint32>(Best) << (i * 2);
+		}
+	}
+	for(int32 i = 0; i < 4; i++)
+	{
+		Out[4 + i] = static_cast<uint8>(Indices >> (i * 8));
+	}
+}
+
+// Alpha part of a BC3 block, in its eight values mode.
+static void EncodeAlphaBlock(const uint8* Block, uint8* Out)
+{
+	int32 MinAlpha = 255;
+	int32 MaxAlpha = 0;
+	for(int32 i = 0; i < 16; i++)
+	{
+		MinAlpha = FMath::Min<int32>(MinAlpha, Block[i * 4 + 3]);
+		MaxAlpha = FMath::Max<int32>(MaxAlpha, Block[i * 4 + 3]);
+	}
+	Out[0] = static_cast<uint8>(MaxAlpha);
+	Out[1] = static_cast<uint8>(MinAlpha);
+
+	uint64 Indices = 0;
+	if(MaxAlpha != MinAlpha)
+	{
+		int32 Palette[8];
+		Palette[0] = MaxAlpha;
+		Palette[1] = MinAlpha;
+		for(int32 i = 1; i < 7; i++)
+		{
+			Palette[i + 1] = ((7 - i) * MaxAlpha + i * MinAlpha) / 7;
+		}
+
+		for(int32 i = 0; i < 16; i++)
+		{
+			int32 Best = 0;
+			int32 BestDistance = MAX_int32;
+			for(int32 p = 0; p < 8; p++)
+			{
+				int32 Distance = FMath::Abs(Block[i * 4 + 3] - Palette[p]);
+				if(Distance < BestDistance)
+				{
+					Best = p;
+					BestDistance = Distance;
+				}
+			}
+			Indices |= static_cast<uint64>(Best) << (i * 3);
+		}
+	}
+	for(int32 i = 0; i < 6; i++)
+	{
+		Out[2 + i] = static_cast<uint8>(Indices >> (i * 8));
+	}
+}
+
+bool FPolyTextureCompressor::CanCompress(int32 Width, int32 Height)
+{
+	return Width > 0 && Height > 0 && Width % 4 == 0 && Height % 4 == 0;
+}
+
+bool FPolyTextureCompressor::HasAlpha(const uint8* BGRA, int32 NumPixels)
+{
+	for(int32 i = 0; i < NumPixels; i++)
+	{
+		if(BGRA[i * 4 + 3] != 255)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FPolyTextureCompressor::Compress(const uint8* BGRA, int32 Width, int32 Height, const TArray<FPolyMip>& Mips, FPolyCompressedTexture& Compressed)
+{
+	if(!CanCompress(Width, Height))
+	{
+		return false;
+	}
+
+	// BC1 has a single bit of alpha, images with any go to BC3.
+	bool bAlpha = HasAlpha(BGRA, Width * Height);
+	Compressed.PixelFormat = bAlpha ? PF_DXT5 : PF_DXT1;
+	Compressed.Mips.SetNum(Mips.Num() + 1);
+	CompressMip(BGRA, Width, Height, bAlpha, Compressed.Mips[0]);
+	for(int32 i = 0; i < Mips.Num(); i++)
+	{
+		CompressMip(Mips[i].Data.GetData(), Mips[i].Width, Mips[i].Height, bAlpha, Compressed.Mips[i + 1]);
+	}
+	return true;
+}
+
+void FPolyTextureCompressor::EncodeBlockBC1(const uint8* Block, uint8* Out)
+{
+	EncodeColorBlock(Block, Out);
+}
+
+void FPolyTextureCompressor::EncodeBlockBC3(const uint8* Block, uint8* Out)
+{
+	EncodeAlphaBlock(Block, Out);
+	EncodeColorBlock(Block, Out + 8);
+}
+
+void FPolyTextureCompressor::CompressMip(const uint8* BGRA, int32 Width, int32 Height, bool bAlpha, FPolyMip& Mip)
+{
+	int32 BlocksX = (Width + 3) / 4;
+	int32 BlocksY = (Height + 3) / 4;
+	int32 BlockBytes = bAlpha ? 16 : 8;
+	Mip.Width = Width;
+	Mip.Height = Height;
+	Mip.Data.SetNumUninitialized(BlocksX * BlocksY * BlockBytes);
+
+	// Rows of blocks are independent.
+	uint8* Data = Mip.Data.GetData();
+	ParallelFor(BlocksY, [BGRA, Width, Height, BlocksX, BlockBytes, bAlpha, Data](int32 BlockY)
+	{
+		uint8 Block[64];
+		for(int32 BlockX = 0; BlockX < BlocksX; BlockX++)
+		{
+			GatherBlock(BGRA, Width, Height, BlockX, BlockY, Block);
+			uint8* Out = Data + (BlockY * BlocksX + BlockX) * BlockBytes;
+			if(bAlpha)
+			{
+				EncodeBlockBC3(Block, Out);
+			}
+			else
+			{
+				EncodeBlockBC1(Block, Out);
+			}
+		}
+	}, BlocksX * BlocksY < COMPRESS_PARALLEL_MIN_BLOCKS);
+}
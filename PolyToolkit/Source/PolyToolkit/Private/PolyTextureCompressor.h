@@ -0,0 +1,59 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PixelFormat.h"
+#include "PolyMipGenerator.h"
+
+/**
+ * A texture compressed to PF_DXT1 or PF_DXT5, largest mip first. Mips are
+ * made of 4x4 blocks, the ones smaller than a block still take a whole one.
+ */
+struct FPolyCompressedTexture
+{
+	EPixelFormat PixelFormat = PF_Unknown;
+	TArray<FPolyMip> Mips;
+};
+
+/**
+ * CPU encoder for BC1 (DXT1) and BC3 (DXT5) textures. Plain computations on
+ * pixel buffers, it needs neither a GPU nor the RHI and runs on any thread.
+ */
+class FPolyTextureCompressor
+{
+public:
+	/** True if Width and Height can be compressed, the top mip must be made of whole blocks. */
+	static bool CanCompress(int32 Width, int32 Height);
+
+	/** True if any of the NumPixels BGRA pixels is not fully opaque. */
+	static bool HasAlpha(const uint8* BGRA, int32 NumPixels);
+
+	/**
+	 * Compresses a BGRA image and its BGRA Mips, see FPolyMipGenerator, to
+	 * BC3 if the image has alpha and to BC1 otherwise. Returns false if the
+	 * size of the image cannot be compressed.
+	 */
+	static bool Compress(const uint8* BGRA, int32 Width, int32 Height, const TArray<FPolyMip>& Mips, FPolyCompressedTexture& Compressed);
+
+	/** Encodes a block of 4x4 BGRA pixels, row after row, to the 8 bytes of a BC1 block. */
+	static void EncodeBlockBC1(const uint8* Block, uint8* Out);
+
+	/** Encodes a block of 4x4 BGRA pixels, row after row, to the 16 bytes of a BC3 block. */
+	static void EncodeBlockBC3(const uint8* Block, uint8* Out);
+
+private:
+	static void CompressMip(const uint8* BGRA, int32 Width, int32 Height, bool bAlpha, FPolyMip& Mip);
+};
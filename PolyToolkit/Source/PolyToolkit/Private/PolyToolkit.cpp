@@ -14,18 +14,37 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
-#include "Gltf2Importer.h"
-#include "JsonObjectConverter.h"
 #include "Regex.h"
+#include "PolyAssetCatalog.h"
+#include "PolyAssetJson.h"
 #include "PolyAssetResponse.h"
+#include "PolyDiskCache.h"
+#include "PolyDownloadScheduler.h"
+#include "GltfMeshSection.h"
+#include "PolyImportSession.h"
+#include "PolyMaterialCache.h"
+#include "PolyTextureCache.h"
 #include "PolyToolkit.h"
+#include "PolyToolkitStats.h"
+#include "Async/Async.h"
+
+DEFINE_STAT(STAT_PolyDecodePrimitives);
+DEFINE_STAT(STAT_PolyDecodeImages);
+
+TAutoConsoleVariable<int32> CVarPolyParallelDecode(
+	TEXT("poly.ParallelDecode"),
+	1,
+	TEXT("0 decodes the primitives of imported glTF models and their attributes on a single thread."));
 
 UPolyToolkit* UPolyToolkit::PolyToolkitInstance = NULL;
 
 UPolyToolkit::UPolyToolkit(const class FObjectInitializer& PCIP) : Super(PCIP)
 {
 	HttpModule = &FHttpModule::Get();
-	PendingDownloads = 0;
+	DownloadScheduler = NULL;
+	MaterialCache = NULL;
+	TextureCache = NULL;
+	DiskCache = NULL;
 }
 
 UPolyToolkit* UPolyToolkit::GetPolyToolkitInstance()
@@ -53,22 +72,32 @@ void UPolyToolkit::GetAsset(const FString& ApiKey, const FString& AssetName, con
 
 void UPolyToolkit::OnGetAssetResponseReceived(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful)
 {
-	FPolyAssetResponse AssetResponse;
-	if (Response.IsValid() && bWasSuccessful)
+	if (Response.IsValid() && bWasSuccessful && Response->GetResponseCode() == HTTP_RESPONSE_OK)
 	{
-		if(Response->GetResponseCode() == HTTP_RESPONSE_OK)
+		// Decode on the thread pool, the body of the response is not touched
+		// by anyone else once it is complete.
+		TWeakObjectPtr<UPolyToolkit> WeakThis(this);
+		Async<void>(EAsyncExecution::ThreadPool, [WeakThis, Response]()
 		{
-			FPolyAsset Asset;
-			if (FJsonObjectConverter::JsonObjectStringToUStruct(Response->GetContentAsString(), &Asset, 0, 0))
+			FPolyAssetResponse AssetResponse;
+			AssetResponse.Success = ParsePolyAsset(Response->GetContent(), AssetResponse.PolyAsset);
+			AsyncTask(ENamedThreads::GameThread, [WeakThis, Response, AssetResponse = MoveTemp(AssetResponse)]() mutable
 			{
-				AssetResponse.PolyAsset = Asset;
-				AssetResponse.Success = true;
-				OnGetAssetComplete.ExecuteIfBound(AssetResponse);
-				return;
-			}
-		}
+				if(WeakThis.IsValid())
+				{
+					if(!AssetResponse.Success)
+					{
+						AssetResponse.ErrorMessage = Response->GetContentAsString();
+					}
+					WeakThis->OnGetAssetComplete.ExecuteIfBound(AssetResponse);
+				}
+			});
+		});
+		return;
 	}
-	AssetResponse.ErrorMessage = Response->GetContentAsString();
+
+	FPolyAssetResponse AssetResponse;
+	AssetResponse.ErrorMessage = Response.IsValid() ? Response->GetContentAsString() : FString();
 	AssetResponse.Success = false;
 	OnGetAssetComplete.ExecuteIfBound(AssetResponse);
 }
@@ -122,108 +151,139 @@ void UPolyToolkit::ListAssets(const FString& ApiKey, const FString& Keywords, bo
 
 void UPolyToolkit::OnListAssetsResponseReceived(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful)
 {
-	FPolyAssetListResponse AssetListResponse;
-	if (Response.IsValid() && bWasSuccessful)
+	if (Response.IsValid() && bWasSuccessful && Response->GetResponseCode() == HTTP_RESPONSE_OK)
 	{
-		if(Response->GetResponseCode() == HTTP_RESPONSE_OK)
+		// Pages of a thousand assets take a while to decode, keep them off
+		// the game thread.
+		TWeakObjectPtr<UPolyToolkit> WeakThis(this);
+		Async<void>(EAsyncExecution::ThreadPool, [WeakThis, Response]()
 		{
-			FPolyAssetList AssetList;
-			if (FJsonObjectConverter::JsonObjectStringToUStruct(Response->GetContentAsString(), &AssetList, 0, 0))
+			FPolyAssetListResponse AssetListResponse;
+			AssetListResponse.Success = ParsePolyAssetList(Response->GetContent(), AssetListResponse.PolyAssetList);
+			AsyncTask(ENamedThreads::GameThread, [WeakThis, Response, AssetListResponse = MoveTemp(AssetListResponse)]() mutable
 			{
-				AssetListResponse.PolyAssetList = AssetList;
-				AssetListResponse.Success = true;
-				OnListAssetsComplete.ExecuteIfBound(AssetListResponse);
-				return;
-			}
-		}
+				if(WeakThis.IsValid())
+				{
+					if(!AssetListResponse.Success)
+					{
+						AssetListResponse.ErrorMessage = Response->GetContentAsString();
+					}
+					WeakThis->OnListAssetsComplete.ExecuteIfBound(AssetListResponse);
+				}
+			});
+		});
+		return;
 	}
-	AssetListResponse.ErrorMessage = Response->GetContentAsString();
+
+	FPolyAssetListResponse AssetListResponse;
+	AssetListResponse.ErrorMessage = Response.IsValid() ? Response->GetContentAsString() : FString();
 	AssetListResponse.Success = false;
 	OnListAssetsComplete.ExecuteIfBound(AssetListResponse);
 }
 
+UPolyAssetCatalog* UPolyToolkit::CreateAssetCatalog()
+{
+	return NewObject<UPolyAssetCatalog>(GetTransientPackage());
+}
+
 void UPolyToolkit::ImportAsset(UObject* WorldContextObject, const FPolyAsset& Asset, const FOnImportAssetComplete& OnImportAssetCompleteCallback)
+{
+	ImportAssetWithOptions(WorldContextObject, Asset, FPolyImportOptions(), OnImportAssetCompleteCallback);
+}
+
+void UPolyToolkit::ImportAssetWithOptions(UObject* WorldContextObject, const FPolyAsset& Asset, const FPolyImportOptions& Options, const FOnImportAssetComplete& OnImportAssetCompleteCallback)
+{
+	ImportAssetWithProgress(WorldContextObject, Asset, Options, FOnImportAssetProgress(), OnImportAssetCompleteCallback);
+}
+
+void UPolyToolkit::ImportAssetWithProgress(UObject* WorldContextObject, const FPolyAsset& Asset, const FPolyImportOptions& Options, const FOnImportAssetProgress& OnImportAssetProgressCallback, const FOnImportAssetComplete& OnImportAssetCompleteCallback)
 {
 	UPolyToolkit* PolyToolkit = GetPolyToolkitInstance();
-	PolyToolkit->OnImportAssetComplete = OnImportAssetCompleteCallback;
-	PolyToolkit->WorldContextObject = WorldContextObject;
 
-	bool SupportedFormatFound = false;
 	for(auto& PolyFormat : Asset.formats)
 	{
 		if(PolyFormat.formatType == "GLTF2" || PolyFormat.formatType == "GLTF")
 		{
-			PolyToolkit->ImportedAsset = Asset;
-			PolyToolkit->PendingDownloads = PolyFormat.resources.Num() + 1; // The root plus all the resources.
-			PolyToolkit->DownloadResource(PolyFormat.root, Asset.name);
-			for(auto& Resource : PolyFormat.resources)
-			{
-				PolyToolkit->DownloadResource(Resource, Asset.name);
-			}
-			SupportedFormatFound = true;
-			break;
+			UPolyImportSession* ImportSession = NewObject<UPolyImportSession>(PolyToolkit);
+			PolyToolkit->ImportSessions.Add(ImportSession);
+			ImportSession->Start(WorldContextObject, Asset, PolyFormat, Options, OnImportAssetProgressCallback, OnImportAssetCompleteCallback);
+			return;
 		}
 	}
 
-	if(!SupportedFormatFound)
-	{
-		FPolyActorResponse ActorResponse;
-		ActorResponse.ErrorMessage = "No supported format was found. Currently only GLTF and GLTF2 formats are supported.";
-		ActorResponse.Success = false;
-		PolyToolkit->OnImportAssetComplete.ExecuteIfBound(ActorResponse);
-	}
+	FPolyActorResponse ActorResponse;
+	ActorResponse.ErrorMessage = "No supported format was found. Currently only GLTF and GLTF2 formats are supported.";
+	ActorResponse.Success = false;
+	OnImportAssetCompleteCallback.ExecuteIfBound(ActorResponse);
 }
 
-void UPolyToolkit::DownloadResource(const FPolyFile& File, const FString& AssetName)
+void UPolyToolkit::OnImportSessionComplete(UPolyImportSession* ImportSession)
 {
-	UHttpDownload* ResourceDownload = NewObject<UHttpDownload>();
-	ResourceDownload->Download(File, AssetName, GetPolyToolkitInstance());
+	ImportSessions.Remove(ImportSession);
 }
 
-void UPolyToolkit::OnDownloadResourceComplete(bool Status)
+UPolyDownloadScheduler* UPolyToolkit::GetDownloadScheduler()
 {
-	PendingDownloads--;
-	if(PendingDownloads == 0)
+	if(DownloadScheduler == NULL)
 	{
-		ImportModel();
+		DownloadScheduler = NewObject<UPolyDownloadScheduler>(this);
 	}
+	return DownloadScheduler;
 }
 
-void UPolyToolkit::ImportModel()
+void UPolyToolkit::SetMaxConcurrentDownloads(int32 MaxDownloads)
 {
-	FPolyActorResponse ActorResponse;
+	GetPolyToolkitInstance()->GetDownloadScheduler()->SetMaxConcurrentDownloads(MaxDownloads);
+}
 
-	UWorld* World = GEngine->GetWorldFromContextObjectChecked(WorldContextObject);
-	AActor* PolyActor = World->SpawnActor<AActor>(AActor::StaticClass());
+int32 UPolyToolkit::GetQueuedDownloadCount()
+{
+	return GetPolyToolkitInstance()->GetDownloadScheduler()->GetQueuedDownloadCount();
+}
+
+int32 UPolyToolkit::GetActiveDownloadCount()
+{
+	return GetPolyToolkitInstance()->GetDownloadScheduler()->GetActiveDownloadCount();
+}
 
-	bool Loaded = false;
-	for (auto& FileFormat : ImportedAsset.formats)
+UPolyMaterialCache* UPolyToolkit::GetMaterialCache()
+{
+	if(MaterialCache == NULL)
 	{
-		if (FileFormat.formatType == "GLTF2")
-		{
-			UGltf2Importer* Gltf2Importer = NewObject<UGltf2Importer>();
-			Gltf2Importer->ImportModel(FileFormat, ImportedAsset.name, PolyActor);
-			Loaded = true;
-			break;
-		}
-		else if(FileFormat.formatType == "GLTF")
-		{
-			UGltf1Importer* Gltf1Importer = NewObject<UGltf1Importer>();
-			Gltf1Importer->ImportModel(FileFormat, ImportedAsset.name, PolyActor);
-			Loaded = true;
-			break;
-		}
+		MaterialCache = NewObject<UPolyMaterialCache>(this);
 	}
-	if(Loaded)
+	return MaterialCache;
+}
+
+UPolyTextureCache* UPolyToolkit::GetTextureCache()
+{
+	if(TextureCache == NULL)
 	{
-		ActorResponse.Actor = PolyActor;
-		ActorResponse.Success = true;
+		TextureCache = NewObject<UPolyTextureCache>(this);
 	}
-	else
+	return TextureCache;
+}
+
+void UPolyToolkit::ClearSharedMaterials()
+{
+	GetPolyToolkitInstance()->GetMaterialCache()->Empty();
+}
+
+void UPolyToolkit::SetDiskCacheSize(int32 MaxMegabytes)
+{
+	GetPolyToolkitInstance()->GetDiskCache()->SetMaxBytes(static_cast<int64>(MaxMegabytes) * 1024 * 1024);
+}
+
+void UPolyToolkit::ClearDiskCache()
+{
+	GetPolyToolkitInstance()->GetDiskCache()->Empty();
+}
+
+UPolyDiskCache* UPolyToolkit::GetDiskCache()
+{
+	if(DiskCache == NULL)
 	{
-		ActorResponse.ErrorMessage = "Model could not be imported";
-		ActorResponse.Success = false;
+		DiskCache = NewObject<UPolyDiskCache>(this);
 	}
-	OnImportAssetComplete.ExecuteIfBound(ActorResponse);
+	return DiskCache;
 }
-
@@ -0,0 +1,27 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+/** Stats of the toolkit, shown with "stat PolyToolkit". */
+DECLARE_STATS_GROUP(TEXT("PolyToolkit"), STATGROUP_PolyToolkit, STATCAT_Advanced);
+
+/** Decoding of all the primitives of a model, on the import worker. */
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Decode Primitives"), STAT_PolyDecodePrimitives, STATGROUP_PolyToolkit, );
+
+/** Decoding of the images of a model to pixels, on any thread. */
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Decode Images"), STAT_PolyDecodeImages, STATGROUP_PolyToolkit, );
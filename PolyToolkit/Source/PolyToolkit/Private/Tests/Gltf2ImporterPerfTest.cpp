@@ -0,0 +1,141 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CoreMinimal.h"
+#include "Gltf2Importer.h"
+#include "GltfMeshSection.h"
+#include "PolyAsset.h"
+#include "PolyImportOptions.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/Package.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace Gltf2ImporterPerfTest
+{
+	// Meshes of the synthetic model, one primitive each.
+	const int32 NumMeshes = 64;
+
+	// Vertices of every primitive, enough for its attributes to decode in parallel.
+	const int32 NumVertices = 4 * GltfParallelAttributesMinVertices;
+
+	// Imports with each setting, the fastest one is reported.
+	const int32 NumRuns = 5;
+
+	/**
+	 * Resources of a glTF2 model whose meshes all share one buffer: float
+	 * positions, normals and texture coordinates, and 32-bit indices.
+	 */
+	void MakeModel(FPolyFormat& Format, TMap<FString, FPolySharedContent>& Resources)
+	{
+		const int32 PositionsSize = NumVertices * 3 * sizeof(float);
+		const int32 TexCoordsSize = NumVertices * 2 * sizeof(float);
+		const int32 IndicesSize = NumVertices * 3 * sizeof(uint32);
+
+		FRandomStream Random(0x9170);
+		TSharedRef<TArray<uint8>, ESPMode::ThreadSafe> SharedBuffer = MakeShareable(new TArray<uint8>());
+		Resources.Add(TEXT("model.bin"), SharedBuffer);
+		TArray<uint8>& Buffer = *SharedBuffer;
+		Buffer.SetNumUninitialized(PositionsSize * 2 + TexCoordsSize + IndicesSize);
+		float* Floats = reinterpret_cast<float*>(Buffer.GetData());
+		for(int32 i = 0; i < NumVertices * 8; i++)
+		{
+			Floats[i] = Random.FRandRange(-1.0f, 1.0f);
+		}
+		uint32* Indices = reinterpret_cast<uint32*>(Buffer.GetData() + PositionsSize * 2 + TexCoordsSize);
+		for(int32 i = 0; i < NumVertices * 3; i++)
+		{
+			Indices[i] = Random.RandHelper(NumVertices);
+		}
+
+		TArray<FString> Meshes;
+		for(int32 i = 0; i < NumMeshes; i++)
+		{
+			Meshes.Add(TEXT("{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":1,\"TEXCOORD_0\":2},\"indices\":3}]}"));
+		}
+		FString Json = FString::Printf(TEXT(
+			"{\"asset\":{\"version\":\"2.0\"},"
+			"\"buffers\":[{\"uri\":\"model.bin\",\"byteLength\":%d}],"
+			"\"bufferViews\":["
+				"{\"buffer\":0,\"byteOffset\":0,\"byteLength\":%d},"
+				"{\"buffer\":0,\"byteOffset\":%d,\"byteLength\":%d},"
+				"{\"buffer\":0,\"byteOffset\":%d,\"byteLength\":%d},"
+				"{\"buffer\":0,\"byteOffset\":%d,\"byteLength\":%d}],"
+			"\"accessors\":["
+				"{\"bufferView\":0,\"componentType\":5126,\"count\":%d,\"type\":\"VEC3\",\"min\":[-1,-1,-1],\"max\":[1,1,1]},"
+				"{\"bufferView\":1,\"componentType\":5126,\"count\":%d,\"type\":\"VEC3\"},"
+				"{\"bufferView\":2,\"componentType\":5126,\"count\":%d,\"type\":\"VEC2\"},"
+				"{\"bufferView\":3,\"componentType\":5125,\"count\":%d,\"type\":\"SCALAR\"}],"
+			"\"meshes\":[%s]}"),
+			Buffer.Num(),
+			PositionsSize,
+			PositionsSize, PositionsSize,
+			PositionsSize * 2, TexCoordsSize,
+			PositionsSize * 2 + TexCoordsSize, IndicesSize,
+			NumVertices, NumVertices, NumVertices, NumVertices * 3,
+			*FString::Join(Meshes, TEXT(",")));
+
+		FTCHARToUTF8 Utf8(*Json);
+		Resources.Add(TEXT("model.gltf"), MakeShareable(new TArray<uint8>(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length())));
+		Format.formatType = TEXT("GLTF2");
+		Format.root.relativePath = TEXT("model.gltf");
+	}
+
+	// Fastest of NumRuns imports with poly.ParallelDecode set to ParallelDecode.
+	double TimeImport(UGltf2Importer* Importer, const FPolyFormat& Format, const TMap<FString, FPolySharedContent>& Resources, int32 ParallelDecode, bool& bParsed)
+	{
+		CVarPolyParallelDecode->Set(ParallelDecode, ECVF_SetByCode);
+		double Best = DBL_MAX;
+		for(int32 Run = 0; Run < NumRuns; Run++)
+		{
+			double Start = FPlatformTime::Seconds();
+			bParsed = Importer->ParseModelFromMemory(Format, Resources);
+			Best = FMath::Min(Best, (FPlatformTime::Seconds() - Start) * 1000.0);
+		}
+		return Best;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGltf2ParallelDecodePerfTest, "PolyToolkit.Perf.ParallelDecode",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FGltf2ParallelDecodePerfTest::RunTest(const FString& Parameters)
+{
+	using namespace Gltf2ImporterPerfTest;
+
+	FPolyFormat Format;
+	TMap<FString, FPolySharedContent> Resources;
+	MakeModel(Format, Resources);
+
+	UGltf2Importer* Importer = NewObject<UGltf2Importer>(GetTransientPackage());
+	Importer->BeginImport(FPolyImportOptions());
+
+	// Parsing the JSON costs the same with both settings, only the decode of
+	// the primitives and their attributes differs.
+	int32 ParallelDecode = CVarPolyParallelDecode.GetValueOnGameThread();
+	bool bParsed = false;
+	double SingleThreadTime = TimeImport(Importer, Format, Resources, 0, bParsed);
+	TestTrue(TEXT("Model parses on a single thread"), bParsed);
+	double ParallelTime = TimeImport(Importer, Format, Resources, 1, bParsed);
+	TestTrue(TEXT("Model parses in parallel"), bParsed);
+	CVarPolyParallelDecode->Set(ParallelDecode, ECVF_SetByCode);
+
+	AddInfo(FString::Printf(TEXT("%d primitives of %d vertices on %d worker threads: %.2f ms -> %.2f ms (%.2fx)"),
+		NumMeshes, NumVertices, FTaskGraphInterface::Get().GetNumWorkerThreads(), SingleThreadTime, ParallelTime, SingleThreadTime / ParallelTime));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
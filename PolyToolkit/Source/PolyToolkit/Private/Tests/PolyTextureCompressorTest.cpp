@@ -0,0 +1,249 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CoreMinimal.h"
+#include "PolyMipGenerator.h"
+#include "PolyTextureCompressor.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace PolyTextureCompressorTest
+{
+	void UnpackRGB565(uint16 Color, int32* RGB)
+	{
+		int32 R = (Color >> 11) & 31;
+		int32 G = (Color >> 5) & 63;
+		int32 B = Color & 31;
+		RGB[0] = (R << 3) | (R >> 2);
+		RGB[1] = (G << 2) | (G >> 4);
+		RGB[2] = (B << 3) | (B >> 2);
+	}
+
+	/**
+	 * Decodes the color part of a BC1 or BC3 block to 4x4 BGRA pixels, the
+	 * way a GPU does, in both of its modes. Alpha is left as is, except for
+	 * the transparent color of the three colors mode.
+	 */
+	void DecodeColorBlock(const uint8* In, uint8* Block)
+	{
+		uint16 Color0 = In[0] | (In[1] << 8);
+		uint16 Color1 = In[2] | (In[3] << 8);
+		int32 Palette[4][4];
+		UnpackRGB565(Color0, Palette[0]);
+		UnpackRGB565(Color1, Palette[1]);
+		Palette[0][3] = Palette[1][3] = Palette[2][3] = 255;
+		for(int32 c = 0; c < 3; c++)
+		{
+			if(Color0 > Color1)
+			{
+				Palette[2][c] = (2 * Palette[0][c] + Palette[1][c]) / 3;
+				Palette[3][c] = (Palette[0][c] + 2 * Palette[1][c]) / 3;
+			}
+			else
+			{
+				Palette[2][c] = (Palette[0][c] + Palette[1][c]) / 2;
+				Palette[3][c] = 0;
+			}
+		}
+		Palette[3][3] = Color0 > Color1 ? 255 : 0;
+
+		uint32 Indices = In[4] | (In[5] << 8) | (In[6] << 16) | (static_cast<uint32>(In[7]) << 24);
+		for(int32 i = 0; i < 16; i++)
+		{
+			const int32* Color = Palette[(Indices >> (i * 2)) & 3];
+			Block[i * 4 + 0] = static_cast<uint8>(Color[2]);
+			Block[i * 4 + 1] = static_cast<uint8>(Color[1]);
+			Block[i * 4 + 2] = static_cast<uint8>(Color[0]);
+			if(Color[3] == 0)
+			{
+				Block[i * 4 + 3] = 0;
+			}
+		}
+	}
+
+	// Decodes the alpha part of a BC3 block into the alpha of 4x4 BGRA pixels.
+	void DecodeAlphaBlock(const uint8* In, uint8* Block)
+	{
+		int32 Palette[8];
+		Palette[0] = In[0];
+		Palette[1] = In[1];
+		if(Palette[0] > Palette[1])
+		{
+			for(int32 i = 1; i < 7; i++)
+			{
+				Palette[i + 1] = ((7 - i) * Palette[0] + i * Palette[1]) / 7;
+			}
+		}
+		else
+		{
+			for(int32 i = 1; i < 5; i++)
+			{
+				Palette[i + 1] = ((5 - i) * Palette[0] + i * Palette[1]) / 5;
+			}
+			Palette[6] = 0;
+			Palette[7] = 255;
+		}
+
+		uint64 Indices = 0;
+		for(int32 i = 0; i < 6; i++)
+		{
+			Indices |= static_cast<uint64>(In[2 + i]) << (i * 8);
+		}
+		for(int32 i = 0; i < 16; i++)
+		{
+			Block[i * 4 + 3] = static_cast<uint8>(Palette[(Indices >> (i * 3)) & 7]);
+		}
+	}
+
+	void DecodeBlockBC1(const uint8* In, uint8* Block)
+	{
+		for(int32 i = 0; i < 16; i++)
+		{
+			Block[i * 4 + 3] = 255;
+		}
+		DecodeColorBlock(In, Block);
+	}
+
+	void DecodeBlockBC3(const uint8* In, uint8* Block)
+	{
+		DecodeAlphaBlock(In, Block);
+		DecodeColorBlock(In + 8, Block);
+	}
+
+	// Largest difference between the channels of two blocks of 4x4 BGRA pixels.
+	int32 MaxError(const uint8* A, const uint8* B, int32 Channel)
+	{
+		int32 Error = 0;
+		for(int32 i = 0; i < 16; i++)
+		{
+			Error = FMath::Max(Error, FMath::Abs(A[i * 4 + Channel] - B[i * 4 + Channel]));
+		}
+		return Error;
+	}
+
+	int32 MaxColorError(const uint8* A, const uint8* B)
+	{
+		return FMath::Max3(MaxError(A, B, 0), MaxError(A, B, 1), MaxError(A, B, 2));
+	}
+
+	void SetPixel(uint8* BGRA, int32 Pixel, int32 R, int32 G, int32 B, int32 A)
+	{
+		BGRA[Pixel * 4 + 0] = static_cast<uint8>(B);
+		BGRA[Pixel * 4 + 1] = static_cast<uint8>(G);
+		BGRA[Pixel * 4 + 2] = static_cast<uint8>(R);
+		BGRA[Pixel * 4 + 3] = static_cast<uint8>(A);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPolyTextureCompressorTest, "PolyToolkit.TextureCompressor",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPolyTextureCompressorTest::RunTest(const FString& Parameters)
+{
+	using namespace PolyTextureCompressorTest;
+
+	uint8 Block[64];
+	uint8 Encoded[16];
+	uint8 Decoded[64];
+
+	// A solid block only loses the precision of RGB565.
+	for(int32 i = 0; i < 16; i++)
+	{
+		SetPixel(Block, i, 200, 120, 40, 255);
+	}
+	FPolyTextureCompressor::EncodeBlockBC1(Block, Encoded);
+	DecodeBlockBC1(Encoded, Decoded);
+	TestTrue(TEXT("Solid block decodes within RGB565 precision"), MaxColorError(Block, Decoded) <= 4);
+
+	// Columns of a gradient between two colors fall on the four colors of
+	// the palette.
+	for(int32 i = 0; i < 16; i++)
+	{
+		int32 x = i % 4;
+		SetPixel(Block, i, 240 - x * 60, 30 + x * 50, 100, 255);
+	}
+	FPolyTextureCompressor::EncodeBlockBC1(Block, Encoded);
+	DecodeBlockBC1(Encoded, Decoded);
+	TestTrue(TEXT("Two color gradient decodes within RGB565 precision"), MaxColorError(Block, Decoded) <= 6);
+	TestEqual(TEXT("BC1 blocks stay opaque"), MaxError(Block, Decoded, 3), 0);
+
+	// Sixteen levels of alpha fall within half a step of the eight of a BC3 block.
+	for(int32 i = 0; i < 16; i++)
+	{
+		SetPixel(Block, i, 60, 180, 220, i * 17);
+	}
+	FPolyTextureCompressor::EncodeBlockBC3(Block, Encoded);
+	DecodeBlockBC3(Encoded, Decoded);
+	TestTrue(TEXT("Alpha ramp decodes within half an alpha step"), MaxError(Block, Decoded, 3) <= 19);
+	TestEqual(TEXT("Alpha ramp keeps its transparent end"), static_cast<int32>(Decoded[3]), 0);
+	TestEqual(TEXT("Alpha ramp keeps its opaque end"), static_cast<int32>(Decoded[15 * 4 + 3]), 255);
+	TestTrue(TEXT("Alpha ramp color decodes within RGB565 precision"), MaxColorError(Block, Decoded) <= 4);
+
+	// Any pixel that is not fully opaque needs BC3.
+	const int32 Width = 16;
+	const int32 Height = 8;
+	TArray<uint8> Image;
+	Image.SetNumUninitialized(Width * Height * 4);
+	for(int32 i = 0; i < Width * Height; i++)
+	{
+		SetPixel(Image.GetData(), i, i % Width * 16, i / Width * 32, 128, 255);
+	}
+	TestFalse(TEXT("Opaque image has no alpha"), FPolyTextureCompressor::HasAlpha(Image.GetData(), Width * Height));
+
+	TArray<FPolyMip> Mips;
+	FPolyMipGenerator::Generate(Image.GetData(), Width, Height, Mips);
+	TestEqual(TEXT("16x8 image has 4 mips"), Mips.Num(), 4);
+
+	FPolyCompressedTexture Compressed;
+	TestTrue(TEXT("Opaque image compresses"), FPolyTextureCompressor::Compress(Image.GetData(), Width, Height, Mips, Compressed));
+	TestEqual(TEXT("Opaque image compresses to DXT1"), static_cast<int32>(Compressed.PixelFormat), static_cast<int32>(PF_DXT1));
+	TestEqual(TEXT("DXT1 blocks take 8 bytes"), Compressed.Mips[0].Data.Num(), (Width / 4) * (Height / 4) * 8);
+
+	Image[(Width * Height - 1) * 4 + 3] = 254;
+	TestTrue(TEXT("Translucent pixel is alpha"), FPolyTextureCompressor::HasAlpha(Image.GetData(), Width * Height));
+	TestTrue(TEXT("Translucent image compresses"), FPolyTextureCompressor::Compress(Image.GetData(), Width, Height, Mips, Compressed));
+	TestEqual(TEXT("Translucent image compresses to DXT5"), static_cast<int32>(Compressed.PixelFormat), static_cast<int32>(PF_DXT5));
+
+	// Every level is compressed, mips smaller than a block take a whole one.
+	TestEqual(TEXT("Compressed texture has the image and its mips"), Compressed.Mips.Num(), Mips.Num() + 1);
+	for(int32 i = 0; i < Compressed.Mips.Num(); i++)
+	{
+		int32 MipWidth = i == 0 ? Width : Mips[i - 1].Width;
+		int32 MipHeight = i == 0 ? Height : Mips[i - 1].Height;
+		const FPolyMip& Mip = Compressed.Mips[i];
+		TestEqual(*FString::Printf(TEXT("Mip %d width"), i), Mip.Width, MipWidth);
+		TestEqual(*FString::Printf(TEXT("Mip %d height"), i), Mip.Height, MipHeight);
+		TestEqual(*FString::Printf(TEXT("Mip %d blocks"), i), Mip.Data.Num(), ((MipWidth + 3) / 4) * ((MipHeight + 3) / 4) * 16);
+	}
+
+	TestFalse(TEXT("Sizes that are not multiples of 4 do not compress"), FPolyTextureCompressor::Compress(Image.GetData(), 6, 8, Mips, Compressed));
+
+	// Black and white average to middle gray in linear space, which is 188
+	// in sRGB. Averaging the sRGB values would give 128, as alpha does.
+	uint8 Checker[16];
+	SetPixel(Checker, 0, 0, 0, 0, 0);
+	SetPixel(Checker, 1, 255, 255, 255, 255);
+	SetPixel(Checker, 2, 255, 255, 255, 255);
+	SetPixel(Checker, 3, 0, 0, 0, 0);
+	FPolyMip Mip;
+	FPolyMipGenerator::Downsample(Checker, 2, 2, Mip);
+	TestEqual(TEXT("sRGB black and white average to 188"), static_cast<int32>(Mip.Data[2]), 188);
+	TestEqual(TEXT("sRGB averaging keeps every channel"), static_cast<int32>(Mip.Data[0]), static_cast<int32>(Mip.Data[2]));
+	TestEqual(TEXT("Alpha is averaged linearly"), static_cast<int32>(Mip.Data[3]), 128);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,138 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PolyAsset.h"
+#include "PolyAssetList.h"
+
+#include "PolyAssetCatalog.generated.h"
+
+/**
+ * @ingroup PolyToolkit
+ * An enum to specify the order of the Assets returned by a catalog query.
+ */
+UENUM(BlueprintType)
+enum class EPolyCatalogOrder : uint8
+{
+	/** Orders Assets by the time they were created, with newest results first. */
+	Newest,
+	/** Orders Assets by the time they were created, with oldest results first. */
+	Oldest,
+	/** Orders Assets by triangle count, with the simplest results first. */
+	FewestTriangles,
+	/** Orders Assets by triangle count, with the most detailed results first. */
+	MostTriangles,
+	/** Orders Assets alphabetically by display name. */
+	DisplayName,
+	/** Orders Assets alphabetically by author name. */
+	AuthorName
+};
+
+/**
+ * Criteria an Asset must match to be returned by a catalog query.
+ */
+USTRUCT(BlueprintType)
+struct FPolyCatalogFilter
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Restricts results to only Assets that contain the given format. */
+	UPROPERTY(BlueprintReadWrite)
+	EPolyFormat Format = EPolyFormat::Any;
+
+	/** Restricts results to only Assets listed in the given category. */
+	UPROPERTY(BlueprintReadWrite)
+	EPolyCategory Category = EPolyCategory::Any;
+
+	/** Restricts results to only Assets of this author. Empty for any author. */
+	UPROPERTY(BlueprintReadWrite)
+	FString AuthorName;
+
+	/**
+	 * Restricts results to only Assets with a format of at most this many
+	 * triangles. 0 for any triangle count.
+	 */
+	UPROPERTY(BlueprintReadWrite)
+	int32 MaxTriangleCount = 0;
+
+	/** Restricts results to only Assets curated by the Poly team. */
+	UPROPERTY(BlueprintReadWrite)
+	bool CuratedOnly = false;
+};
+
+/**
+ * Assets collected from ListAssets results, which can be filtered and sorted
+ * locally instead of listing them again. The fields queries look at are
+ * parsed once and stored column by column, author names are kept once each,
+ * so a query over thousands of Assets only compares integers.
+ */
+UCLASS(BlueprintType)
+class POLYTOOLKIT_API UPolyAssetCatalog : public UObject
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	/**
+	 * Adds the Assets of a page returned by ListAssets. Assets already in the
+	 * catalog are updated.
+	 *
+	 * @param AssetList	A page of Assets returned by ListAssets.
+	 * @param Category	The category the page was listed with. Poly does not return the category of an Asset, so this is the only way to know it.
+	 */
+	UFUNCTION(BlueprintCallable, Category="PolyToolkit")
+	void AddAssets(const FPolyAssetList& AssetList, EPolyCategory Category);
+
+	/**
+	 * Returns the index of every Asset matching Filter, sorted by OrderBy.
+	 * Indices stay valid until the catalog is emptied.
+	 */
+	UFUNCTION(BlueprintCallable, Category="PolyToolkit")
+	TArray<int32> Query(const FPolyCatalogFilter& Filter, EPolyCatalogOrder OrderBy) const;
+
+	/** Returns the Asset at Index, as returned by Query. */
+	UFUNCTION(BlueprintPure, Category="PolyToolkit")
+	FPolyAsset GetAsset(int32 Index) const;
+
+	/** Returns the number of Assets in the catalog. */
+	UFUNCTION(BlueprintPure, Category="PolyToolkit")
+	int32 Num() const { return Assets.Num(); }
+
+	/** Removes every Asset. */
+	UFUNCTION(BlueprintCallable, Category="PolyToolkit")
+	void Empty();
+
+private:
+	int32 InternAuthor(const FString& AuthorName);
+
+	// Full Assets, only read when one is returned.
+	TArray<FPolyAsset> Assets;
+
+	// Index of every Asset by its name.
+	TMap<FString, int32> AssetsByName;
+
+	// Columns used by queries, one element per Asset.
+	TArray<uint8> FormatMasks;
+	TArray<EPolyCategory> Categories;
+	TArray<int32> TriangleCounts;
+	TArray<int64> CreateTimes;
+	TArray<int32> Authors;
+	TArray<bool> Curated;
+
+	// Interned author names, Authors indexes AuthorNames.
+	TArray<FString> AuthorNames;
+	TMap<FString, int32> AuthorIds;
+};
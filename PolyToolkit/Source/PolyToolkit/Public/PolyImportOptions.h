@@ -0,0 +1,83 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PolyImportOptions.generated.h"
+
+/**
+ * Options that control how ImportAssetWithOptions loads an Asset.
+ */
+USTRUCT(BlueprintType)
+struct FPolyImportOptions
+{
+	GENERATED_USTRUCT_BODY()
+
+	/**
+	 * If true the downloaded files are kept in memory and the model is loaded
+	 * from there. Nothing is written to the game's content folder.
+	 */
+	UPROPERTY(BlueprintReadWrite)
+	bool InMemory = false;
+
+	/**
+	 * If true node transforms are baked into the vertices and the whole model
+	 * becomes a single mesh component, with one section per material. Only
+	 * used by glTF2 models.
+	 */
+	UPROPERTY(BlueprintReadWrite)
+	bool MergeMeshes = false;
+
+	/**
+	 * If true materials reuse the instances created by previous imports with
+	 * the same parameters and textures, instead of creating new ones. Shared
+	 * instances must not be modified, it would change every actor using them.
+	 */
+	UPROPERTY(BlueprintReadWrite)
+	bool ShareMaterials = false;
+
+	/**
+	 * Maximum time in milliseconds spent creating the components of the model
+	 * on the game thread each frame. Large models are then built over several
+	 * frames. 0 creates the whole model in a single frame.
+	 */
+	UPROPERTY(BlueprintReadWrite)
+	float FrameBudgetMs = 0.0f;
+
+	/**
+	 * If true base color textures are compressed on worker threads, to DXT5
+	 * when they have alpha and DXT1 otherwise, with their mips. They take 4
+	 * to 8 times less memory. Only used by glTF2 models, and only for images
+	 * whose size is a multiple of 4.
+	 */
+	UPROPERTY(BlueprintReadWrite)
+	bool CompressTextures = false;
+
+	/**
+	 * If true textures get a full mip chain, filtered on worker threads, so
+	 * distant surfaces do not alias. It costs a third more texture memory.
+	 * Only used by glTF2 models.
+	 */
+	UPROPERTY(BlueprintReadWrite)
+	bool GenerateMips = true;
+
+	/**
+	 * Largest width or height of a texture. Larger images are reduced to
+	 * their first mip that fits, the levels above are dropped. 0 keeps images
+	 * at their full size. Only used by glTF2 models.
+	 */
+	UPROPERTY(BlueprintReadWrite)
+	int32 MaxTextureSize = 0;
+};
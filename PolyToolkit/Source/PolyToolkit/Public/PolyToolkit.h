@@ -21,6 +21,7 @@
 #include "PolyAssetResponse.h"
 #include "PolyAssetListResponse.h"
 #include "PolyActorResponse.h"
+#include "PolyImportOptions.h"
 
 #include "PolyToolkit.generated.h"
 
@@ -29,6 +30,14 @@
 DECLARE_DYNAMIC_DELEGATE_OneParam(FOnGetAssetComplete, FPolyAssetResponse, PolyAssetResponse);
 DECLARE_DYNAMIC_DELEGATE_OneParam(FOnListAssetsComplete, FPolyAssetListResponse, PolyAssetListResponse);
 DECLARE_DYNAMIC_DELEGATE_OneParam(FOnImportAssetComplete, FPolyActorResponse, PolyActorResponse);
+DECLARE_DYNAMIC_DELEGATE_OneParam(FOnImportAssetProgress, float, Progress);
+
+class UPolyAssetCatalog;
+class UPolyDiskCache;
+class UPolyDownloadScheduler;
+class UPolyImportSession;
+class UPolyMaterialCache;
+class UPolyTextureCache;
 
 /**
  * A UObject that encapsulates the PolyToolkit API.
@@ -71,9 +80,18 @@ public:
 	UFUNCTION(BlueprintCallable, meta = (HidePin = "PageSize|OrderBy|PageToken"), Category="PolyToolkit")
 	static void ListAssets(const FString& ApiKey, const FString& Keywords, bool Curated, EPolyCategory Category, EPolyComplexity MaxComplexity, EPolyFormat Format, int32 PageSize, EPolyOrder OrderBy, const FString& PageToken, const FOnListAssetsComplete& OnListAssetsCallback);
 
+	/**
+	 * Creates an empty catalog to collect the results of ListAssets and
+	 * filter or sort them locally. Keep a reference to it for as long as it
+	 * is used.
+	 */
+	UFUNCTION(BlueprintCallable, Category="PolyToolkit")
+	static UPolyAssetCatalog* CreateAssetCatalog();
+
 	/**
 	 * Imports an Asset at runtime. This method does not support assets that
-         * are created with Tilt Brush.
+         * are created with Tilt Brush. Several imports can be in flight at
+         * the same time, each one executes its own callback.
 	 *
 	 * @param Asset	The Asset to be loaded. This should be returned by GetAsset or ListAssets.
 	 * @param OnImportCompleteCallback	A callback to be executed after loading the model.
@@ -81,33 +99,126 @@ public:
 	UFUNCTION(BlueprintCallable, meta = (WorldContext = WorldContextObject), Category="PolyToolkit")
 	static void ImportAsset(UObject* WorldContextObject, const FPolyAsset& Asset, const FOnImportAssetComplete& OnImportCompleteCallback);
 
-private:
-	void ImportModel();
+	/**
+	 * Imports an Asset at runtime using the given options. This method does
+	 * not support assets that are created with Tilt Brush.
+	 *
+	 * @param Asset	The Asset to be loaded. This should be returned by GetAsset or ListAssets.
+	 * @param Options	Options that control how the Asset is loaded.
+	 * @param OnImportCompleteCallback	A callback to be executed after loading the model.
+	 */
+	UFUNCTION(BlueprintCallable, meta = (WorldContext = WorldContextObject), Category="PolyToolkit")
+	static void ImportAssetWithOptions(UObject* WorldContextObject, const FPolyAsset& Asset, const FPolyImportOptions& Options, const FOnImportAssetComplete& OnImportCompleteCallback);
 
+	/**
+	 * Imports an Asset at runtime using the given options and reports how
+	 * much of the model has been created. This method does not support assets
+	 * that are created with Tilt Brush.
+	 *
+	 * @param Asset	The Asset to be loaded. This should be returned by GetAsset or ListAssets.
+	 * @param Options	Options that control how the Asset is loaded.
+	 * @param OnImportProgressCallback	A callback executed every frame the model is being created, with the fraction of its components created so far.
+	 * @param OnImportCompleteCallback	A callback to be executed after loading the model.
+	 */
+	UFUNCTION(BlueprintCallable, meta = (WorldContext = WorldContextObject), Category="PolyToolkit")
+	static void ImportAssetWithProgress(UObject* WorldContextObject, const FPolyAsset& Asset, const FPolyImportOptions& Options, const FOnImportAssetProgress& OnImportProgressCallback, const FOnImportAssetComplete& OnImportCompleteCallback);
+
+	/**
+	 * Sets the maximum number of files that are downloaded at the same time
+	 * across all imports. Files over the limit wait in a queue.
+	 *
+	 * @param MaxDownloads	The maximum number of downloads in flight. Defaults to 6.
+	 */
+	UFUNCTION(BlueprintCallable, Category="PolyToolkit")
+	static void SetMaxConcurrentDownloads(int32 MaxDownloads);
+
+	/**
+	 * Returns the number of files waiting to be downloaded.
+	 */
+	UFUNCTION(BlueprintPure, Category="PolyToolkit")
+	static int32 GetQueuedDownloadCount();
+
+	/**
+	 * Returns the number of files currently being downloaded.
+	 */
+	UFUNCTION(BlueprintPure, Category="PolyToolkit")
+	static int32 GetActiveDownloadCount();
+
+	/**
+	 * Releases the material instances shared between imports, see
+	 * FPolyImportOptions::ShareMaterials. Actors already imported keep theirs.
+	 */
+	UFUNCTION(BlueprintCallable, Category="PolyToolkit")
+	static void ClearSharedMaterials();
+
+	/**
+	 * Sets the disk space used to keep downloaded files between runs.
+	 * Importing an asset whose files are all cached makes no request. The
+	 * least recently used files are deleted when the cache gets too large.
+	 * Files imported to disk are also kept in the content folder, those take
+	 * up to twice their size on disk.
+	 *
+	 * @param MaxMegabytes	Size of the cache. Defaults to 256, 0 disables the cache and deletes its files.
+	 */
+	UFUNCTION(BlueprintCallable, Category="PolyToolkit")
+	static void SetDiskCacheSize(int32 MaxMegabytes);
+
+	/**
+	 * Deletes every file of the disk cache, they are downloaded again by the
+	 * next imports.
+	 */
+	UFUNCTION(BlueprintCallable, Category="PolyToolkit")
+	static void ClearDiskCache();
+
+private:
 	void OnGetAssetResponseReceived(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful);
 	void OnListAssetsResponseReceived(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful);
 
 public:
 	/** @private */
-	void OnDownloadResourceComplete(bool Status);
+	void OnImportSessionComplete(UPolyImportSession* ImportSession);
+
+	/** @private */
+	UPolyDownloadScheduler* GetDownloadScheduler();
+
+	/** @private */
+	UPolyMaterialCache* GetMaterialCache();
+
+	/** @private */
+	UPolyTextureCache* GetTextureCache();
+
+	/** @private */
+	UPolyDiskCache* GetDiskCache();
 
 public:
 	// Callback delegates.
 	FOnGetAssetComplete OnGetAssetComplete;
 	FOnListAssetsComplete OnListAssetsComplete;
-	FOnImportAssetComplete OnImportAssetComplete;
 
 private:
-	void DownloadResource(const FPolyFile& File, const FString& AssetName);
-
 	// Singleton instance.
 	static UPolyToolkit* PolyToolkitInstance;
 
-	UObject* WorldContextObject;
 	FHttpModule* HttpModule;
 
-	// Fields for importing  asset and downloading resources.
-	int32 PendingDownloads;
-	FPolyAsset ImportedAsset;
+	// Imports that are still downloading or loading.
+	UPROPERTY()
+	TArray<UPolyImportSession*> ImportSessions;
+
+	// Queues and throttles the resource downloads of all imports.
+	UPROPERTY()
+	UPolyDownloadScheduler* DownloadScheduler;
+
+	// Material instances shared between imports.
+	UPROPERTY()
+	UPolyMaterialCache* MaterialCache;
+
+	// Textures decoded by previous imports.
+	UPROPERTY()
+	UPolyTextureCache* TextureCache;
+
+	// Files downloaded by previous imports, kept on disk between runs.
+	UPROPERTY()
+	UPolyDiskCache* DiskCache;
 };
 
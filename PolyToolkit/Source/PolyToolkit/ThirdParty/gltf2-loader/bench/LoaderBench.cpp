@@ -0,0 +1,148 @@
+// MIT License
+//
+// Copyright (c) 2017 The glTF2-loader Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Times gltf2::load on a file and reports the peak memory of the process.
+// The same source builds against any revision of the loader that has
+// gltf2::load(std::string), see build.sh, so each loader runs in its own
+// process and the peak RSS only counts its allocations.
+//
+//   gltf2-bench generate <out.gltf> <count>
+//   gltf2-bench load <file.gltf> [iterations]
+
+// Unreal compiles every source file of the plugin, this one is only built
+// by build.sh.
+#if defined(GLTF2_STANDALONE)
+
+#include <gltf2/glTF2.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+// Peak resident set size of the process in kilobytes.
+long peakRssKb() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return static_cast<long>(counters.PeakWorkingSetSize / 1024);
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+// Writes a synthetic asset with count nodes, meshes and accessor pairs, the
+// shape of large Tilt Brush and Blocks exports: many small primitives
+// sharing one buffer.
+int generate(const std::string& fileName, int count) {
+    std::string binName = fileName.substr(0, fileName.find_last_of('.')) + ".bin";
+    std::string binUri = binName.substr(binName.find_last_of("/\\") + 1);
+
+    // One triangle, positions then indices, shared by every accessor.
+    std::vector<char> bin(3 * 12 + 3 * 2 + 2);
+    float positions[9] = { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+    uint16_t indices[3] = { 0, 1, 2 };
+    std::memcpy(bin.data(), positions, sizeof(positions));
+    std::memcpy(bin.data() + sizeof(positions), indices, sizeof(indices));
+    std::ofstream(binName, std::ios::binary).write(bin.data(), bin.size());
+
+    std::ofstream out(fileName);
+    out << "{\"asset\":{\"version\":\"2.0\",\"generator\":\"gltf2-bench\"},\"scene\":0,\"scenes\":[{\"nodes\":[";
+    for (int i = 0; i < count; ++i) {
+        out << (i ? "," : "") << i;
+    }
+    out << "]}],\"nodes\":[";
+    for (int i = 0; i < count; ++i) {
+        out << (i ? "," : "") << "{\"name\":\"node" << i << "\",\"mesh\":" << i
+            << ",\"translation\":[" << i << ".5,0.25," << -i << ".125],\"rotation\":[0,0,0,1],\"scale\":[1,1,1]}";
+    }
+    out << "],\"meshes\":[";
+    for (int i = 0; i < count; ++i) {
+        out << (i ? "," : "") << "{\"name\":\"mesh" << i << "\",\"primitives\":[{\"attributes\":{\"POSITION\":" << i * 2
+            << "},\"indices\":" << i * 2 + 1 << ",\"mode\":4,\"material\":0}]}";
+    }
+    out << "],\"materials\":[{\"name\":\"default\",\"pbrMetallicRoughness\":{\"baseColorFactor\":[1,1,1,1],\"metallicFactor\":0,\"roughnessFactor\":0.5}}]";
+    out << ",\"accessors\":[";
+    for (int i = 0; i < count; ++i) {
+        out << (i ? "," : "")
+            << "{\"bufferView\":0,\"componentType\":5126,\"count\":3,\"type\":\"VEC3\",\"min\":[0,0,0],\"max\":[1,1,0]},"
+            << "{\"bufferView\":1,\"componentType\":5123,\"count\":3,\"type\":\"SCALAR\"}";
+    }
+    out << "],\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":36},{\"buffer\":0,\"byteOffset\":36,\"byteLength\":6}]";
+    out << ",\"buffers\":[{\"uri\":\"" << binUri << "\",\"byteLength\":" << bin.size() << "}]}";
+    return out ? 0 : 1;
+}
+
+int load(const std::string& fileName, int iterations) {
+    std::vector<double> times;
+    size_t nodes = 0, meshes = 0, accessors = 0;
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        {
+            gltf2::Asset asset = gltf2::load(fileName);
+            nodes = asset.nodes.size();
+            meshes = asset.meshes.size();
+            accessors = asset.accessors.size();
+        }
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    std::printf("nodes %zu meshes %zu accessors %zu\n", nodes, meshes, accessors);
+    std::printf("load min %.1f ms median %.1f ms over %d runs\n", times.front(), times[times.size() / 2], iterations);
+    std::printf("peak rss %.1f MB\n", peakRssKb() / 1024.0);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "generate" && argc == 4) {
+        return generate(argv[2], std::atoi(argv[3]));
+    }
+    if (mode == "load" && (argc == 3 || argc == 4)) {
+        return load(argv[2], argc == 4 ? std::max(1, std::atoi(argv[3])) : 5);
+    }
+    std::fprintf(stderr, "usage: %s generate <out.gltf> <count>\n       %s load <file.gltf> [iterations]\n", argv[0], argv[0]);
+    return 2;
+}
+
+#endif // GLTF2_STANDALONE
@@ -0,0 +1,52 @@
+#!/bin/sh
+# Builds the loader benchmark against the current one-pass loader and
+# against the nlohmann::json DOM loader it replaced, then loads the same
+# file through both. The DOM loader is taken from the git history of the
+# plugin, each loader runs in its own process.
+#
+#   ./build.sh [file.gltf] [iterations]
+#
+# Without a file a synthetic asset with 60000 nodes, meshes and accessor
+# pairs is generated. CXX, CXXFLAGS, BUILD_DIR and DOM_REVISION are
+# honored.
+
+set -e
+
+BENCH_DIR=$(cd "$(dirname "$0")" && pwd)
+LOADER_DIR=$(dirname "$BENCH_DIR")
+# Outside of the plugin, Unreal compiles every source file under it.
+BUILD_DIR=${BUILD_DIR:-${TMPDIR:-/tmp}/gltf2-bench}
+CXX=${CXX:-c++}
+CXXFLAGS=${CXXFLAGS:--O2}
+
+mkdir -p "$BUILD_DIR"
+
+# Current loader.
+$CXX -std=c++14 $CXXFLAGS -DGLTF2_STANDALONE -I"$LOADER_DIR/include" \
+    "$BENCH_DIR/LoaderBench.cpp" "$LOADER_DIR/src/gltf2/glTF2.cpp" -o "$BUILD_DIR/gltf2-bench"
+
+# DOM loader, exported from git. Its last revision is the one before
+# ext/json.hpp was deleted, found by path so rewritten history still works.
+REPO_ROOT=$(git -C "$LOADER_DIR" rev-parse --show-toplevel)
+LOADER_PATH=$(cd "$LOADER_DIR" && git rev-parse --show-prefix)
+if [ -z "$DOM_REVISION" ]; then
+    DOM_REVISION=$(git -C "$REPO_ROOT" log -1 --format=%h --diff-filter=D -- "${LOADER_PATH}ext/json.hpp")^
+fi
+rm -rf "$BUILD_DIR/dom"
+mkdir -p "$BUILD_DIR/dom"
+git -C "$REPO_ROOT" archive "$DOM_REVISION" "$LOADER_PATH" | tar -x -C "$BUILD_DIR/dom"
+DOM_DIR="$BUILD_DIR/dom/$LOADER_PATH"
+$CXX -std=c++14 $CXXFLAGS -DGLTF2_STANDALONE -I"$DOM_DIR/include" -I"$DOM_DIR/ext" \
+    "$BENCH_DIR/LoaderBench.cpp" "$DOM_DIR/src/gltf2/glTF2.cpp" -o "$BUILD_DIR/gltf2-bench-dom"
+
+FILE=$1
+if [ -z "$FILE" ]; then
+    FILE="$BUILD_DIR/synthetic.gltf"
+    "$BUILD_DIR/gltf2-bench" generate "$FILE" 60000
+fi
+ITERATIONS=${2:-5}
+
+echo "== one-pass loader"
+"$BUILD_DIR/gltf2-bench" load "$FILE" "$ITERATIONS"
+echo "== DOM loader ($DOM_REVISION)"
+"$BUILD_DIR/gltf2-bench-dom" load "$FILE" "$ITERATIONS"
@@ -0,0 +1,260 @@
+// MIT License
+//
+// Copyright (c) 2017 The glTF2-loader Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// The SSSE3 decoder is compiled on every x86 target whatever the baseline
+// of the build, and only used if the CPU running the code supports it.
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define GLTF2_BASE64_SSSE3 1
+#include <tmmintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define GLTF2_TARGET_SSSE3
+#else
+#define GLTF2_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+#endif
+
+namespace gltf2 {
+namespace base64 {
+
+namespace detail {
+
+// Every input character maps to its 6 bits already shifted into place in the
+// 3 output bytes, one table per position in the 4 character group. Invalid
+// characters set bit 24 so a whole group is validated with a single test.
+struct Tables {
+    static const uint32_t invalid = 0x01000000;
+
+    uint32_t d0[256];
+    uint32_t d1[256];
+    uint32_t d2[256];
+    uint32_t d3[256];
+
+    Tables() {
+        for (int i = 0; i < 256; ++i) {
+            d0[i] = d1[i] = d2[i] = d3[i] = invalid;
+        }
+
+        static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        for (uint32_t v = 0; v < 64; ++v) {
+            uint8_t c = static_cast<uint8_t>(alphabet[v]);
+            d0[c] = v << 2;
+            d1[c] = (v >> 4) | ((v & 0x0f) << 12);
+            d2[c] = ((v >> 2) << 8) | ((v & 0x03) << 22);
+            d3[c] = v << 16;
+        }
+    }
+};
+
+inline const Tables& tables() {
+    static const Tables instance;
+    return instance;
+}
+
+inline size_t paddingLength(const char* src, size_t length) {
+    size_t padding = 0;
+    while (padding < 2 && padding < length && src[length - padding - 1] == '=') {
+        ++padding;
+    }
+    return padding;
+}
+
+#if defined(GLTF2_BASE64_SSSE3)
+inline bool cpuHasSSSE3() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+#else
+    return __builtin_cpu_supports("ssse3") != 0;
+#endif
+}
+
+inline bool hasSSSE3() {
+    static const bool supported = cpuHasSSSE3();
+    return supported;
+}
+
+// Decodes 16 characters into 12 bytes, but stores 16 bytes to dst.
+// Returns false if any of the characters is not part of the alphabet.
+GLTF2_TARGET_SSSE3 inline bool decodeBlock(const char* src, char* dst) {
+    const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask2F = _mm_set1_epi8(0x2f);
+
+    __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+
+    // Classify every character by its nibbles, a valid one never has a bit
+    // in common between both lookups.
+    __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(in, 4), mask2F);
+    __m128i loNibbles = _mm_and_si128(in, mask2F);
+    __m128i lo = _mm_shuffle_epi8(lutLo, loNibbles);
+    __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0xffff) {
+        return false;
+    }
+
+    // Translate characters to their 6 bit values.
+    __m128i eq2F = _mm_cmpeq_epi8(in, mask2F);
+    __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(eq2F, hiNibbles));
+    __m128i values = _mm_add_epi8(in, roll);
+
+    // Pack 4 x 6 bits into 3 bytes per 32 bit lane and gather the lanes.
+    __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    __m128i packed = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+    __m128i out = _mm_shuffle_epi8(packed, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), out);
+    return true;
+}
+
+// Decodes blocks of 16 characters while at least 24 are left, since each
+// block stores 4 bytes past its output and the following groups must
+// overwrite them. Returns the number of characters decoded and advances
+// dst, or sets valid to false on the first invalid block.
+GLTF2_TARGET_SSSE3 inline size_t decodeBlocks(const char* src, size_t characters, char*& dst, bool& valid) {
+    size_t i = 0;
+    while (characters - i >= 24) {
+        if (!decodeBlock(src + i, dst)) {
+            valid = false;
+            break;
+        }
+        i += 16;
+        dst += 12;
+    }
+    return i;
+}
+#endif
+
+} // detail
+
+/**
+ * @brief      Number of bytes encoded by a base64 string
+ *
+ * @param[in]  src     The base64 characters, with or without padding
+ * @param[in]  length  The number of characters
+ *
+ * @return     The decoded size in bytes
+ */
+inline size_t decodedSize(const char* src, size_t length) {
+    size_t characters = length - detail::paddingLength(src, length);
+    return characters / 4 * 3 + (characters % 4 == 3 ? 2 : characters % 4 == 2 ? 1 : 0);
+}
+
+/**
+ * @brief      Decode a base64 string straight into dst
+ *
+ * @param[in]  src     The base64 characters, with or without padding
+ * @param[in]  length  The number of characters
+ * @param[out] dst     The output, must hold decodedSize(src, length) bytes
+ *
+ * @return     False if src is not valid base64
+ */
+inline bool decode(const char* src, size_t length, char* dst) {
+    const detail::Tables& t = detail::tables();
+    size_t characters = length - detail::paddingLength(src, length);
+    if (characters % 4 == 1) {
+        return false;
+    }
+
+    size_t i = 0;
+
+#if defined(GLTF2_BASE64_SSSE3)
+    if (detail::hasSSSE3()) {
+        bool valid = true;
+        i = detail::decodeBlocks(src, characters, dst, valid);
+        if (!valid) {
+            return false;
+        }
+    }
+#endif
+
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(src);
+    for (; characters - i >= 4; i += 4) {
+        uint32_t x = t.d0[in[i]] | t.d1[in[i + 1]] | t.d2[in[i + 2]] | t.d3[in[i + 3]];
+        if (x & detail::Tables::invalid) {
+            return false;
+        }
+        dst[0] = static_cast<char>(x);
+        dst[1] = static_cast<char>(x >> 8);
+        dst[2] = static_cast<char>(x >> 16);
+        dst += 3;
+    }
+
+    // Last group of 2 or 3 characters.
+    if (characters - i >= 2) {
+        uint32_t x = t.d0[in[i]] | t.d1[in[i + 1]];
+        if (characters - i == 3) {
+            x |= t.d2[in[i + 2]];
+        }
+        if (x & detail::Tables::invalid) {
+            return false;
+        }
+        dst[0] = static_cast<char>(x);
+        if (characters - i == 3) {
+            dst[1] = static_cast<char>(x >> 8);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief      Find the base64 payload of a data uri
+ *             ("data:[<mediatype>];base64,<data>")
+ *
+ * @param[in]  uri       The uri
+ * @param[out] mimeType  The media type of the data, may be empty
+ * @param[out] data      Offset of the base64 characters in uri
+ *
+ * @return     False if uri is not a base64 data uri
+ */
+inline bool parseDataUri(const std::string& uri, std::string& mimeType, size_t& data) {
+    static const char scheme[] = "data:";
+    static const char encoding[] = ";base64,";
+
+    if (uri.compare(0, sizeof(scheme) - 1, scheme) != 0) {
+        return false;
+    }
+
+    size_t comma = uri.find(',');
+    if (comma == std::string::npos || comma < sizeof(encoding) - 1
+        || uri.compare(comma + 1 - (sizeof(encoding) - 1), sizeof(encoding) - 1, encoding) != 0) {
+        return false;
+    }
+
+    size_t mimeTypeStart = sizeof(scheme) - 1;
+    size_t mimeTypeEnd = comma + 1 - (sizeof(encoding) - 1);
+    mimeType = mimeTypeEnd > mimeTypeStart ? uri.substr(mimeTypeStart, mimeTypeEnd - mimeTypeStart) : std::string();
+    data = comma + 1;
+    return true;
+}
+
+} // base64
+} // gltf2
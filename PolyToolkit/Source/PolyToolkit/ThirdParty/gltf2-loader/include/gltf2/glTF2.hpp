@@ -22,6 +22,8 @@
 
 #pragma once
 
+#include <functional>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -73,7 +75,11 @@ struct Buffer {
     std::string uri;
     uint32_t byteLength = 0;
 
-    char* data = nullptr;
+    const char* data = nullptr;
+
+    // Owns data when it was read by the library, either a read-only file
+    // mapping or a heap copy. Empty when data belongs to a ResourceResolver.
+    std::shared_ptr<const char> storage;
 
     // content
 
@@ -140,6 +146,14 @@ struct Image {
 
     std::string mimeType;
     int32_t bufferView{-1};
+
+    // Contents of the image when it was embedded in a data uri or provided
+    // by a ResourceResolver.
+    const char* data = nullptr;
+    size_t byteLength = 0;
+
+    // Owns data when it was decoded from a data uri.
+    std::shared_ptr<const char> storage;
 };
 
 struct Material {
@@ -269,11 +283,55 @@ struct Asset {
 };
 
 /**
- * @brief      Load a glTF v2.0 asset from a file
+ * @brief      Provides the contents of a resource referenced by the asset
+ *
+ * @param[in]  uri   The uri of the resource, as written in the glTF file
+ * @param[out] data  Pointer to the contents, must outlive the asset
+ * @param[out] size  Size of the contents in bytes
+ *
+ * @return     False if the resource is not available
+ */
+using ResourceResolver = std::function<bool(const std::string& uri, const char*& data, size_t& size)>;
+
+/**
+ * @brief      Load a glTF v2.0 asset from a .gltf or .glb file. The BIN
+ *             chunk of a .glb is mapped and backs the buffer without uri.
+ *             The JSON is read in a single pass straight into the asset,
+ *             no document tree is built.
  *
  * @param[in]  fileName  The file name
  *
  * @return     The asset
  */
 Asset load(std::string fileName);
+
+/**
+ * @brief      Load a glTF v2.0 asset from memory, either the JSON text or a
+ *             whole .glb. Buffers point directly to the BIN chunk or to the
+ *             memory returned by the resolver, nothing is copied. Images
+ *             with an uri get their contents from the resolver too, they
+ *             are left empty if it can't provide them.
+ *
+ *             Nothing is read from disk, so with GLTF2_STANDALONE defined
+ *             the loader builds and runs outside of Unreal.
+ *
+ * @param[in]  data      The glTF JSON or .glb contents
+ * @param[in]  size      The size of data in bytes
+ * @param[in]  resolver  Provides the buffers and images referenced by the asset
+ *
+ * @return     The asset
+ */
+Asset load(const char* data, size_t size, const ResourceResolver& resolver);
+
+/**
+ * @brief      Map the beginning of a file in memory, read only. The same
+ *             mapping backs the buffers of the assets loaded from disk.
+ *
+ * @param[in]  fileName  The file name
+ * @param[in]  size      The number of bytes to map, from the start of the file
+ *
+ * @return     The mapped bytes, unmapped with the last reference, or null if
+ *             the file is smaller than size or can't be mapped
+ */
+std::shared_ptr<const char> mapFile(const std::string& fileName, size_t size);
 } // gltf2
@@ -0,0 +1,438 @@
+// MIT License
+//
+// Copyright (c) 2017 The glTF2-loader Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace gltf2 {
+
+/**
+ * Pull parser over a JSON text in memory. Values are read in document order
+ * straight into the caller's structures, no document tree is ever built.
+ * Malformed input aborts, like every other error of the loader.
+ *
+ *     reader.beginObject();
+ *     while (reader.nextMember(key)) {
+ *         if (key == "name") {
+ *             reader.readString(name);
+ *         } else {
+ *             reader.skipValue();
+ *         }
+ *     }
+ */
+class JsonReader {
+public:
+    enum class Type {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object
+    };
+
+    JsonReader(const char* data, size_t size) : cur_(data), end_(data + size) {
+        // Tolerate an UTF-8 byte order mark.
+        if (size >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+            cur_ += 3;
+        }
+    }
+
+    /**
+     * @brief      Type of the next value, without consuming it
+     */
+    Type peek() {
+        skipWhitespace();
+        if (cur_ == end_) {
+            std::abort();
+        }
+
+        switch (*cur_) {
+        case '{':
+            return Type::Object;
+        case '[':
+            return Type::Array;
+        case '"':
+            return Type::String;
+        case 't':
+        case 'f':
+            return Type::Bool;
+        case 'n':
+            return Type::Null;
+        default:
+            if (*cur_ == '-' || (*cur_ >= '0' && *cur_ <= '9')) {
+                return Type::Number;
+            }
+            std::abort();
+        }
+    }
+
+    void beginObject() {
+        expect('{');
+        enter();
+    }
+
+    /**
+     * @brief      Moves to the next member of the current object
+     *
+     * @param[out] key   The name of the member, its value is read next
+     *
+     * @return     False once the closing brace has been consumed
+     */
+    bool nextMember(std::string& key) {
+        skipWhitespace();
+        if (cur_ != end_ && *cur_ == '}') {
+            ++cur_;
+            leave();
+            return false;
+        }
+        if (!first_) {
+            expect(',');
+        }
+        first_ = false;
+
+        readString(key);
+        expect(':');
+        return true;
+    }
+
+    void beginArray() {
+        expect('[');
+        enter();
+    }
+
+    /**
+     * @brief      Moves to the next element of the current array
+     *
+     * @return     False once the closing bracket has been consumed
+     */
+    bool nextElement() {
+        skipWhitespace();
+        if (cur_ != end_ && *cur_ == ']') {
+            ++cur_;
+            leave();
+            return false;
+        }
+        if (!first_) {
+            expect(',');
+        }
+        first_ = false;
+        return true;
+    }
+
+    void readString(std::string& value) {
+        expect('"');
+        value.clear();
+
+        for (;;) {
+            // Copy the longest run without escapes at once.
+            const char* run = cur_;
+            while (cur_ != end_ && *cur_ != '"' && *cur_ != '\\') {
+                if (static_cast<unsigned char>(*cur_) < 0x20) {
+                    std::abort();
+                }
+                ++cur_;
+            }
+            value.append(run, cur_ - run);
+
+            if (cur_ == end_) {
+                std::abort();
+            }
+            if (*cur_++ == '"') {
+                return;
+            }
+            readEscape(value);
+        }
+    }
+
+    std::string readString() {
+        std::string value;
+        readString(value);
+        return value;
+    }
+
+    double readNumber() {
+        skipWhitespace();
+        const char* start = cur_;
+
+        bool negative = cur_ != end_ && *cur_ == '-';
+        if (negative) {
+            ++cur_;
+        }
+
+        // Integers, the vast majority of glTF numbers, never reach strtod.
+        uint64_t integer = 0;
+        const char* digits = cur_;
+        while (cur_ != end_ && *cur_ >= '0' && *cur_ <= '9') {
+            integer = integer * 10 + static_cast<uint64_t>(*cur_ - '0');
+            ++cur_;
+        }
+        if (cur_ == digits || (*digits == '0' && cur_ - digits > 1)) {
+            std::abort();
+        }
+
+        bool isInteger = cur_ - digits <= 15;
+        if (cur_ != end_ && *cur_ == '.') {
+            isInteger = false;
+            ++cur_;
+            skipDigits();
+        }
+        if (cur_ != end_ && (*cur_ == 'e' || *cur_ == 'E')) {
+            isInteger = false;
+            ++cur_;
+            if (cur_ != end_ && (*cur_ == '+' || *cur_ == '-')) {
+                ++cur_;
+            }
+            skipDigits();
+        }
+
+        if (isInteger) {
+            return negative ? -static_cast<double>(integer) : static_cast<double>(integer);
+        }
+
+        // strtod needs a terminated string, the text is not.
+        char buffer[64];
+        size_t length = static_cast<size_t>(cur_ - start);
+        if (length >= sizeof(buffer)) {
+            std::abort();
+        }
+        std::memcpy(buffer, start, length);
+        buffer[length] = '\0';
+        return std::strtod(buffer, nullptr);
+    }
+
+    template <typename T>
+    T readNumber() {
+        return static_cast<T>(readNumber());
+    }
+
+    bool readBool() {
+        skipWhitespace();
+        if (literal("true")) {
+            return true;
+        }
+        if (literal("false")) {
+            return false;
+        }
+        std::abort();
+    }
+
+    /**
+     * @brief      Reads a fixed size array of numbers
+     *
+     * @param[out] values  The numbers
+     * @param[in]  count   The number of elements the array must have
+     */
+    void readNumbers(float* values, size_t count) {
+        size_t i = 0;
+        beginArray();
+        while (nextElement()) {
+            if (i == count) {
+                std::abort();
+            }
+            values[i++] = readNumber<float>();
+        }
+        if (i != count) {
+            std::abort();
+        }
+    }
+
+    /**
+     * @brief      Skips the next value, whatever its type
+     */
+    void skipValue() {
+        std::string key;
+        switch (peek()) {
+        case Type::Object:
+            beginObject();
+            while (nextMember(key)) {
+                skipValue();
+            }
+            break;
+        case Type::Array:
+            beginArray();
+            while (nextElement()) {
+                skipValue();
+            }
+            break;
+        case Type::String:
+            readString(key);
+            break;
+        case Type::Number:
+            readNumber();
+            break;
+        case Type::Bool:
+            readBool();
+            break;
+        case Type::Null:
+            if (!literal("null")) {
+                std::abort();
+            }
+            break;
+        }
+    }
+
+    /**
+     * @brief      Checks that nothing but whitespace follows the document
+     */
+    void finish() {
+        skipWhitespace();
+        if (cur_ != end_ || depth_ != 0) {
+            std::abort();
+        }
+    }
+
+private:
+    static const int maxDepth = 256;
+
+    void skipWhitespace() {
+        while (cur_ != end_ && (*cur_ == ' ' || *cur_ == '\n' || *cur_ == '\r' || *cur_ == '\t')) {
+            ++cur_;
+        }
+    }
+
+    void skipDigits() {
+        const char* digits = cur_;
+        while (cur_ != end_ && *cur_ >= '0' && *cur_ <= '9') {
+            ++cur_;
+        }
+        if (cur_ == digits) {
+            std::abort();
+        }
+    }
+
+    void expect(char c) {
+        skipWhitespace();
+        if (cur_ == end_ || *cur_ != c) {
+            std::abort();
+        }
+        ++cur_;
+    }
+
+    bool literal(const char* text) {
+        size_t length = std::strlen(text);
+        if (static_cast<size_t>(end_ - cur_) < length || std::memcmp(cur_, text, length) != 0) {
+            return false;
+        }
+        cur_ += length;
+        return true;
+    }
+
+    void enter() {
+        if (++depth_ > maxDepth) {
+            std::abort();
+        }
+        first_ = true;
+    }
+
+    void leave() {
+        --depth_;
+        first_ = false;
+    }
+
+    uint32_t readHex4() {
+        if (end_ - cur_ < 4) {
+            std::abort();
+        }
+
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = *cur_++;
+            value <<= 4;
+            if (c >= '0' && c <= '9') {
+                value |= static_cast<uint32_t>(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                value |= static_cast<uint32_t>(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                value |= static_cast<uint32_t>(c - 'A' + 10);
+            } else {
+                std::abort();
+            }
+        }
+        return value;
+    }
+
+    void readEscape(std::string& value) {
+        if (cur_ == end_) {
+            std::abort();
+        }
+
+        switch (*cur_++) {
+        case '"': value += '"'; return;
+        case '\\': value += '\\'; return;
+        case '/': value += '/'; return;
+        case 'b': value += '\b'; return;
+        case 'f': value += '\f'; return;
+        case 'n': value += '\n'; return;
+        case 'r': value += '\r'; return;
+        case 't': value += '\t'; return;
+        case 'u': break;
+        default: std::abort();
+        }
+
+        uint32_t codePoint = readHex4();
+        if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+            // High surrogate, must be followed by the low one.
+            if (end_ - cur_ < 2 || cur_[0] != '\\' || cur_[1] != 'u') {
+                std::abort();
+            }
+            cur_ += 2;
+            uint32_t low = readHex4();
+            if (low < 0xDC00 || low > 0xDFFF) {
+                std::abort();
+            }
+            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+        } else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) {
+            std::abort();
+        }
+
+        // Encode as UTF-8.
+        if (codePoint < 0x80) {
+            value += static_cast<char>(codePoint);
+        } else if (codePoint < 0x800) {
+            value += static_cast<char>(0xC0 | (codePoint >> 6));
+            value += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else if (codePoint < 0x10000) {
+            value += static_cast<char>(0xE0 | (codePoint >> 12));
+            value += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            value += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else {
+            value += static_cast<char>(0xF0 | (codePoint >> 18));
+            value += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            value += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            value += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    const char* cur_;
+    const char* end_;
+    int depth_ = 0;
+
+    // True right after an opening brace or bracket, no comma is expected.
+    bool first_ = false;
+};
+
+} // gltf2
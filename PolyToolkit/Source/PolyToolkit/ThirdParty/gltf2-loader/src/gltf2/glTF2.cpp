@@ -20,556 +20,193 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#ifndef GLTF2_STANDALONE
 #include "CoreMinimal.h"
+#endif
 #include <gltf2/glTF2.hpp>
 #include <iostream>
+#include <cstring>
 #include <fstream>
 #include <string>
-#include "json.hpp"
+#include "JsonReader.hpp"
 #include "gltf2/Exceptions.hpp"
-
-#include <fstream>
+#include "gltf2/Base64.hpp"
+
+#if defined(_WIN32)
+#ifdef GLTF2_STANDALONE
+#include <windows.h>
+#else
+#include <WindowsHWrapper.h>
+#endif
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace gltf2 {
 
-static void loadAsset(Asset& asset, nlohmann::json& json);
-static void loadScenes(Asset& asset, nlohmann::json& json);
-static void loadMeshes(Asset& asset, nlohmann::json& json);
-static void loadNodes(Asset& asset, nlohmann::json& json);
-static void loadBuffers(Asset& asset, nlohmann::json& json);
-static void loadAccessors(Asset& asset, nlohmann::json& json);
-static void loadBufferViews(Asset& asset, nlohmann::json& json);
-static void loadBufferData(Asset& asset, Buffer& buffer);
-static std::string pathAppend(const std::string& p1, const std::string& p2);
-static void loadMaterials(Asset& asset, nlohmann::json& json);
-static void loadTextureInfo(Material::Texture& texture, nlohmann::json& json);
-static void loadImages(Asset& asset, nlohmann::json& json);
-static void loadSamplers(Asset& asset, nlohmann::json& json);
-static void loadTextures(Asset& asset, nlohmann::json& json);
-
-static void loadAsset(Asset& asset, nlohmann::json& json) {
-    if (json.find("asset") == json.end()) {
-        std::abort();
-    }
+// Where the contents of the buffers come from while loading an asset.
+struct LoadContext {
+    // Resolves external buffers and images, buffers are read from disk when null.
+    const ResourceResolver* resolver = nullptr;
 
-    // version
-    if (json["asset"].find("version") == json["asset"].end()) {
-        std::abort();
-    }
-    if (!json["asset"]["version"].is_string()) {
-        std::abort();
-    }
-
-    asset.metadata.version = json["asset"]["version"].get<std::string>();
+    // BIN chunk of a .glb file, backs the first buffer without uri.
+    const char* binChunk = nullptr;
+    size_t binChunkSize = 0;
 
-    // copyright
-    if (json["asset"].find("copyright") != json["asset"].end()) {
-        if (!json["asset"]["copyright"].is_string()) {
-            std::abort();
-        }
+    // Owner of the whole .glb when it was read by the library.
+    std::shared_ptr<const char> glbStorage;
+};
 
-        asset.metadata.copyright = json["asset"]["copyright"].get<std::string>();
-    }
+static void loadBufferData(Asset& asset, Buffer& buffer, const LoadContext& context);
+static bool isDataUri(const std::string& uri);
+static std::shared_ptr<const char> decodeDataUri(const std::string& uri, std::string& mimeType, size_t& size);
+static std::shared_ptr<const char> readFile(const std::string& fileName, size_t size);
+static std::string pathAppend(const std::string& p1, const std::string& p2);
+static void loadDocument(Asset& asset, const char* data, size_t size, const LoadContext& context);
+static void loadGlb(Asset& asset, const char* data, size_t size, LoadContext& context);
 
-    // generator
-    if (json["asset"].find("generator") != json["asset"].end()) {
-        if (!json["asset"]["generator"].is_string()) {
+static void loadBufferData(Asset& asset, Buffer& buffer, const LoadContext& context) {
+    if (!buffer.uri.size()) {
+        // Only the BIN chunk of a .glb can back a buffer without uri.
+        if (buffer.byteLength > context.binChunkSize) {
             std::abort();
         }
-
-        asset.metadata.generator = json["asset"]["generator"].get<std::string>();
-    }
-
-    // minVersion
-    if (json["asset"].find("minVersion") != json["asset"].end()) {
-        if (!json["asset"]["minVersion"].is_string()) {
-            std::abort();
+        buffer.data = context.binChunk;
+        if (context.glbStorage) {
+            buffer.storage = std::shared_ptr<const char>(context.glbStorage, context.binChunk);
         }
-
-        asset.metadata.minVersion = json["asset"]["minVersion"].get<std::string>();
+        return;
     }
-}
 
-static void loadScenes(Asset& asset, nlohmann::json& json) {
-    if (json.find("scene") != json.end()) {
-        if (!json["scene"].is_number()) {
+    if (isDataUri(buffer.uri)) {
+        std::string mimeType;
+        size_t size = 0;
+        buffer.storage = decodeDataUri(buffer.uri, mimeType, size);
+        if (!buffer.storage || size < buffer.byteLength) {
             std::abort();
         }
-
-        asset.scene = json["scene"].get<int32_t>();
-    }
-
-    if (json.find("scenes") == json.end()) {
+        buffer.data = buffer.storage.get();
         return;
     }
 
-    auto& scenes = json["scenes"];
-    if (!scenes.is_array()) {
-        std::abort();
-    }
-
-    if (asset.scene == -1) {
-        asset.scene = 0;
-    }
-
-    asset.scenes.resize(scenes.size());
-    for (uint32_t i = 0; i < scenes.size(); ++i) {
-        // name
-        if (scenes[i].find("name") != scenes[i].end()) {
-            if (!scenes[i]["name"].is_string()) {
-                std::abort();
-            }
-
-            asset.scenes[i].name = scenes[i]["name"];
-        }
-
-        // nodes
-        if (scenes[i].find("nodes") != scenes[i].end()) {
-            auto& nodes = scenes[i]["nodes"];
-            if (!nodes.is_array()) {
-                std::abort();
-            }
-
-            asset.scenes[i].nodes.resize(nodes.size());
-            for (uint32_t j = 0; j < nodes.size(); ++j) {
-                asset.scenes[i].nodes[j] = nodes[j].get<uint32_t>();
-            }
+    if (context.resolver) {
+        const char* data = nullptr;
+        size_t size = 0;
+        if (!(*context.resolver)(buffer.uri, data, size) || size < buffer.byteLength) {
+            std::abort();
         }
-    }
-}
-
-static void loadMeshes(Asset& asset, nlohmann::json& json) {
-    if (json.find("meshes") == json.end()) {
+        buffer.data = data;
         return;
     }
 
-    auto& meshes = json["meshes"];
+    std::string fileName = pathAppend(asset.dirName, buffer.uri);
 
-    if (!meshes.is_array()) {
-        std::abort();
+    // Map the file so only the pages used by accessors are ever read, fall
+    // back to reading it if it can't be mapped.
+    buffer.storage = mapFile(fileName, buffer.byteLength);
+    if (!buffer.storage) {
+        buffer.storage = readFile(fileName, buffer.byteLength);
     }
-
-    asset.meshes.resize(meshes.size());
-    for (uint32_t i = 0; i < meshes.size(); ++i) {
-        // name
-        if (meshes[i].find("name") != meshes[i].end()) {
-            if (!meshes[i]["name"].is_string()) {
-                std::abort();
-            }
-
-            asset.meshes[i].name = meshes[i]["name"];
-        }
-
-
-        if (meshes[i].find("primitives") == meshes[i].end()) {
-            std::abort();
-        }
-
-        auto& primitives = meshes[i]["primitives"];
-        if (!primitives.is_array()) {
-            std::abort();
-        }
-
-        asset.meshes[i].primitives.resize(primitives.size());
-        for (uint32_t j = 0; j < primitives.size(); ++j) {
-            // indices
-            if (primitives[j].find("indices") != primitives[j].end()) {
-                if (!primitives[j]["indices"].is_number()) {
-                    std::abort();
-                }
-
-                asset.meshes[i].primitives[j].indices = primitives[j]["indices"].get<int32_t>();
-            }
-
-            // material
-            if (primitives[j].find("material") != primitives[j].end()) {
-                if (!primitives[j]["material"].is_number()) {
-                    std::abort();
-                }
-
-                asset.meshes[i].primitives[j].material = primitives[j]["material"].get<int32_t>();
-            }
-
-            // mode
-            if (primitives[j].find("mode") != primitives[j].end()) {
-                if (!primitives[j]["mode"].is_number()) {
-                    std::abort();
-                }
-
-                asset.meshes[i].primitives[j].mode = static_cast<Primitive::Mode>(primitives[j]["mode"].get<uint8_t>());
-            }
-
-            if (primitives[j].find("attributes") == primitives[j].end()) {
-                std::abort();
-            }
-
-            auto& attributes = primitives[j]["attributes"];
-            if (!attributes.is_object()) {
-                std::abort();
-            }
-
-            for (nlohmann::json::iterator it = attributes.begin(); it != attributes.end(); ++it) {
-                asset.meshes[i].primitives[j].attributes[it.key()] = it.value();
-            }
-
-            // TODO: primitives[j]["targets"]
-        }
-
-        // TODO: meshes[i]["weights"]
-        // TODO: meshes[i]["extensions"]
+    if (!buffer.storage) {
+        std::abort();
     }
+    buffer.data = buffer.storage.get();
 }
 
-static void loadNodes(Asset& asset, nlohmann::json& json) {
-    if (json.find("nodes") == json.end()) {
-        return;
-    }
+static bool isDataUri(const std::string& uri) {
+    return uri.compare(0, 5, "data:") == 0;
+}
 
-    auto& nodes = json["nodes"];
-    if (!nodes.is_array()) {
-        std::abort();
+static std::shared_ptr<const char> decodeDataUri(const std::string& uri, std::string& mimeType, size_t& size) {
+    size_t offset = 0;
+    if (!base64::parseDataUri(uri, mimeType, offset)) {
+        return nullptr;
     }
 
-    asset.nodes.resize(nodes.size());
-    for (uint32_t i = 0; i < nodes.size(); ++i) {
-        // name
-        if (nodes[i].find("name") != nodes[i].end()) {
-            if (!nodes[i]["name"].is_string()) {
-                std::abort();
-            }
-
-            asset.nodes[i].name = nodes[i]["name"];
-        }
-
-        // camera
-        if (nodes[i].find("camera") != nodes[i].end()) {
-            if (!nodes[i]["camera"].is_number()) {
-                std::abort();
-            }
-
-            asset.nodes[i].camera = nodes[i]["camera"].get<int32_t>();
-        }
-
-        // children
-        if (nodes[i].find("children") != nodes[i].end()) {
-            auto& children = nodes[i]["children"];
-            if (!children.is_array()) {
-                std::abort();
-            }
-
-            asset.nodes[i].children.resize(children.size());
-            for (uint32_t j = 0; j < children.size(); ++j) {
-                asset.nodes[i].children[j] = children[j].get<uint32_t>();
-            }
-        }
-
-        // skin
-        if (nodes[i].find("skin") != nodes[i].end()) {
-            if (!nodes[i]["skin"].is_number()) {
-                std::abort();
-            }
-
-            asset.nodes[i].skin = nodes[i]["skin"].get<int32_t>();
-        }
-
-        // TODO: nodes[i]["matrix"]
-
-        // mesh
-        if (nodes[i].find("mesh") != nodes[i].end()) {
-            if (!nodes[i]["mesh"].is_number()) {
-                std::abort();
-            }
-
-            asset.nodes[i].mesh = nodes[i]["mesh"].get<int32_t>();
-        }
-
-        // translation
-        if (nodes[i].find("translation") != nodes[i].end()) {
-            if (!nodes[i]["translation"].is_array()) {
-                std::abort();
-            }
-
-            if (nodes[i]["translation"].size() != 3) {
-                std::abort();
-            }
-
-            for (uint32_t j = 0; j < 3; ++j) {
-                if (!nodes[i]["translation"][j].is_number()) {
-                    std::abort();
-                }
-
-                asset.nodes[i].translation[j] = nodes[i]["translation"][j].get<float>();
-            }
-        }
-
-        // rotation
-        if (nodes[i].find("rotation") != nodes[i].end()) {
-            if (!nodes[i]["rotation"].is_array()) {
-                std::abort();
-            }
-
-            if (nodes[i]["rotation"].size() != 4) {
-                std::abort();
-            }
-
-            for (uint32_t j = 0; j < 4; ++j) {
-                if (!nodes[i]["rotation"][j].is_number()) {
-                    std::abort();
-                }
-
-                asset.nodes[i].rotation[j] = nodes[i]["rotation"][j].get<float>();
-            }
-        }
-
-        // scale
-        if (nodes[i].find("scale") != nodes[i].end()) {
-            if (!nodes[i]["scale"].is_array()) {
-                std::abort();
-            }
-
-            if (nodes[i]["scale"].size() != 3) {
-                std::abort();
-            }
-
-            for (uint32_t j = 0; j < 3; ++j) {
-                if (!nodes[i]["scale"][j].is_number()) {
-                    std::abort();
-                }
-
-                asset.nodes[i].scale[j] = nodes[i]["scale"][j].get<float>();
-            }
-        }
-
-        // TODO: nodes[i]["weights"]
+    // Decode straight into the storage of the buffer, the uri is the only
+    // other copy of the data.
+    const char* src = uri.data() + offset;
+    size_t length = uri.size() - offset;
+    size = base64::decodedSize(src, length);
+    std::shared_ptr<char> data(new char[size > 0 ? size : 1], std::default_delete<char[]>());
+    if (!base64::decode(src, length, data.get())) {
+        return nullptr;
     }
+    return data;
 }
 
-static void loadBuffers(Asset& asset, nlohmann::json& json) {
-    if (json.find("buffers") == json.end()) {
-        return;
+std::shared_ptr<const char> mapFile(const std::string& fileName, size_t size) {
+    if (size == 0) {
+        return nullptr;
     }
 
-    auto& buffers = json["buffers"];
-    if (!buffers.is_array()) {
-        std::abort();
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return nullptr;
     }
 
-    asset.buffers.resize(buffers.size());
-    for (uint32_t i = 0; i < buffers.size(); ++i) {
-
-        // name
-        if (buffers[i].find("name") != buffers[i].end()) {
-            if (!buffers[i]["name"].is_string()) {
-                std::abort();
-            }
-            asset.buffers[i].name = buffers[i]["name"];
-        }
-
-        // byteLength
-        if (buffers[i].find("byteLength") == buffers[i].end()) {
-            std::abort();
-        } else if (!buffers[i]["byteLength"].is_number()) {
-            std::abort();
-        }
-        asset.buffers[i].byteLength = buffers[i]["byteLength"].get<int32_t>();
-
-        // uri
-        if (buffers[i].find("uri") != buffers[i].end()) {
-            if (!buffers[i]["uri"].is_string()) {
-                std::abort();
-            }
-
-            asset.buffers[i].uri = buffers[i]["uri"];
-        }
-
-        loadBufferData(asset, asset.buffers[i]);
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || static_cast<uint64_t>(fileSize.QuadPart) < size) {
+        CloseHandle(file);
+        return nullptr;
     }
-}
 
-static void loadAccessors(Asset& asset, nlohmann::json& json) {
-    if (json.find("accessors") == json.end()) {
-        return;
+    // The view keeps the mapping alive, both handles can be closed right away.
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) {
+        return nullptr;
     }
 
-    auto& accessors = json["accessors"];
-
-    if (!accessors.is_array()) {
-        std::abort();
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+    CloseHandle(mapping);
+    if (view == nullptr) {
+        return nullptr;
     }
 
-    asset.accessors.resize(accessors.size());
-    for (uint32_t i = 0; i < accessors.size(); ++i) {
-        // bufferView
-        if (accessors[i].find("bufferView") != accessors[i].end()) {
-            if (!accessors[i]["bufferView"].is_number()) {
-                std::abort();
-            }
-
-            asset.accessors[i].bufferView = accessors[i]["bufferView"].get<int32_t>();
-        }
-
-        // bufferView
-        if (accessors[i].find("bufferView") != accessors[i].end()) {
-            if (!accessors[i]["bufferView"].is_number()) {
-                std::abort();
-            }
-
-            asset.accessors[i].bufferView = accessors[i]["bufferView"].get<int32_t>();
-        }
-
-        // byteOffset
-        if (accessors[i].find("byteOffset") != accessors[i].end()) {
-            if (!accessors[i]["byteOffset"].is_number()) {
-                std::abort();
-            }
-
-            asset.accessors[i].byteOffset = accessors[i]["byteOffset"].get<uint32_t>();
-        }
-
-        // componentType
-        if (accessors[i].find("componentType") == accessors[i].end()) {
-            std::abort();
-        } else if (!accessors[i]["componentType"].is_number()) {
-            std::abort();
-        }
-
-        asset.accessors[i].componentType = static_cast<Accessor::ComponentType>(accessors[i]["componentType"].get<uint16_t>());
-
-        // normalized
-        if (accessors[i].find("normalized") != accessors[i].end()) {
-            if (!accessors[i]["normalized"].is_boolean()) {
-                std::abort();
-            }
-
-            asset.accessors[i].normalized = accessors[i]["normalized"].get<bool>();
-        }
-
-        // count
-        if (accessors[i].find("count") == accessors[i].end()) {
-            std::abort();
-        } else if (!accessors[i]["count"].is_number()) {
-            std::abort();
-        }
-
-        asset.accessors[i].count = accessors[i]["count"].get<uint32_t>();
-
-        // type
-        if (accessors[i].find("type") == accessors[i].end()) {
-            std::abort();
-        } else if (!accessors[i]["type"].is_string()) {
-            std::abort();
-        }
-
-        std::string type = accessors[i]["type"].get<std::string>();
-        if (type == "SCALAR") {
-            asset.accessors[i].type = Accessor::Type::Scalar;
-        } else if (type == "VEC2") {
-            asset.accessors[i].type = Accessor::Type::Vec2;
-        } else if (type == "VEC3") {
-            asset.accessors[i].type = Accessor::Type::Vec3;
-        } else if (type == "VEC4") {
-            asset.accessors[i].type = Accessor::Type::Vec4;
-        } else if (type == "MAT2") {
-            asset.accessors[i].type = Accessor::Type::Mat2;
-        } else if (type == "MAT3") {
-            asset.accessors[i].type = Accessor::Type::Mat3;
-        } else if (type == "MAT4") {
-            asset.accessors[i].type = Accessor::Type::Mat4;
-        } else {
-            std::abort();
-        }
-
-        // TODO: accessors[i]["sparse"]
-        // TODO: accessors[i]["extensions"]
-        // TODO: accessors[i]["min"]
-        // TODO: accessors[i]["max"]
+    return std::shared_ptr<const char>(static_cast<const char*>(view), [](const char* data) {
+        UnmapViewOfFile(data);
+    });
+#else
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return nullptr;
     }
-}
 
-static void loadBufferViews(Asset& asset, nlohmann::json& json) {
-    if (json.find("bufferViews") == json.end()) {
-        return;
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) == -1 || static_cast<size_t>(fileStat.st_size) < size) {
+        close(fd);
+        return nullptr;
     }
 
-    auto& bufferViews = json["bufferViews"];
-    if (!bufferViews.is_array()) {
-        std::abort();
+    // The mapping stays valid after the descriptor is closed.
+    void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        return nullptr;
     }
 
-    asset.bufferViews.resize(bufferViews.size());
-    for (uint32_t i = 0; i < bufferViews.size(); ++i) {
-        // name
-        if (bufferViews[i].find("name") != bufferViews[i].end()) {
-            if (!bufferViews[i]["name"].is_string()) {
-                std::abort();
-            }
-
-            asset.bufferViews[i].name = bufferViews[i]["name"];
-        }
-
-        // buffer
-        if (bufferViews[i].find("buffer") == bufferViews[i].end()) {
-            std::abort();
-        }
-        if (!bufferViews[i]["buffer"].is_number()) {
-            std::abort();
-        }
-        asset.bufferViews[i].buffer = bufferViews[i]["buffer"].get<int32_t>();
-
-        // byteOffset
-        if (bufferViews[i].find("byteOffset") == bufferViews[i].end()) {
-            std::abort();
-        }
-        if (!bufferViews[i]["byteOffset"].is_number()) {
-            std::abort();
-        }
-        asset.bufferViews[i].byteOffset = bufferViews[i]["byteOffset"].get<int32_t>();
-
-        // byteLength
-        if (bufferViews[i].find("byteLength") == bufferViews[i].end()) {
-            std::abort();
-        }
-        if (!bufferViews[i]["byteLength"].is_number()) {
-            std::abort();
-        }
-        asset.bufferViews[i].byteLength = bufferViews[i]["byteLength"].get<int32_t>();
-
-        // byteStride
-        if (bufferViews[i].find("byteStride") != bufferViews[i].end()) {
-            if (!bufferViews[i]["byteStride"].is_number()) {
-                std::abort();
-            }
-
-            asset.bufferViews[i].byteStride = bufferViews[i]["byteStride"].get<int32_t>();
-        }
-
-        // target
-        if (bufferViews[i].find("target") != bufferViews[i].end()) {
-            if (!bufferViews[i]["target"].is_number()) {
-                std::abort();
-            }
-            asset.bufferViews[i].target = static_cast<BufferView::TargetType>(bufferViews[i]["target"].get<uint16_t>());
-        }
-
-        // TODO: bufferViews[i]["extensions"]
-        // TODO: bufferViews[i]["extras"]
-    }
+    return std::shared_ptr<const char>(static_cast<const char*>(view), [size](const char* data) {
+        munmap(const_cast<char*>(data), size);
+    });
+#endif
 }
 
-static void loadBufferData(Asset& asset, Buffer& buffer) {
-    if (!buffer.uri.size() && buffer.byteLength > 0) {
-        std::abort();
-    }
-
-    buffer.data = new char[buffer.byteLength];
-
-    // TODO: load base64 uri
-    std::ifstream fileData(pathAppend(asset.dirName, buffer.uri), std::ios::binary);
+static std::shared_ptr<const char> readFile(const std::string& fileName, size_t size) {
+    std::ifstream fileData(fileName, std::ios::binary);
     if (!fileData.good()) {
-        std::abort();
+        return nullptr;
     }
-    fileData.read(buffer.data, buffer.byteLength);
+
+    char* data = new char[size];
+    fileData.read(data, size);
     fileData.close();
+
+    return std::shared_ptr<const char>(data, std::default_delete<const char[]>());
 }
 
 static std::string pathAppend(const std::string& p1, const std::string& p2) {
@@ -595,391 +232,675 @@ static std::string getDirectoryName(const std::string& path) {
     return path.substr(0, found);
 }
 
-static void loadMaterials(Asset& asset, nlohmann::json& json) {
-    if (json.find("materials") == json.end()) {
-        return;
+static void loadAsset(Asset& asset, JsonReader& reader) {
+    bool hasVersion = false;
+    std::string key;
+
+    reader.beginObject();
+    while (reader.nextMember(key)) {
+        if (key == "version") {
+            reader.readString(asset.metadata.version);
+            hasVersion = true;
+        } else if (key == "copyright") {
+            reader.readString(asset.metadata.copyright);
+        } else if (key == "generator") {
+            reader.readString(asset.metadata.generator);
+        } else if (key == "minVersion") {
+            reader.readString(asset.metadata.minVersion);
+        } else {
+            reader.skipValue();
+        }
     }
 
-    auto& materials = json["materials"];
-    if (!materials.is_array()) {
+    if (!hasVersion) {
         std::abort();
     }
+}
 
-    asset.materials.resize(materials.size());
-    for (uint32_t i = 0; i < materials.size(); ++i) {
-        // name
-        if (materials[i].find("name") != materials[i].end()) {
-            if (!materials[i]["name"].is_string()) {
-                std::abort();
-            }
-
-            asset.materials[i].name = materials[i]["name"];
-        }
-
-        // pbrMetallicRoughness
-        if (materials[i].find("pbrMetallicRoughness") != materials[i].end()) {
-            if (!materials[i]["pbrMetallicRoughness"].is_object()) {
-                std::abort();
-            }
-
-            // pbrMetallicRoughness.baseColorFactor
-            if (materials[i]["pbrMetallicRoughness"].find("baseColorFactor") != materials[i]["pbrMetallicRoughness"].end()) {
-                if (!materials[i]["pbrMetallicRoughness"]["baseColorFactor"].is_array()) {
-                    std::abort();
-                }
-
-                if (materials[i]["pbrMetallicRoughness"]["baseColorFactor"].size() != 4) {
-                    std::abort();
-                }
-
-                for (uint32_t j = 0; j < 4; ++j) {
-                    if (!materials[i]["pbrMetallicRoughness"]["baseColorFactor"][j].is_number()) {
-                        std::abort();
-                    }
+static void loadStrings(std::vector<std::string>& strings, JsonReader& reader) {
+    reader.beginArray();
+    while (reader.nextElement()) {
+        strings.push_back(reader.readString());
+    }
+}
 
-                    asset.materials[i].pbr.baseColorFactor[j] = materials[i]["pbrMetallicRoughness"]["baseColorFactor"][j].get<float>();
+static void loadScenes(Asset& asset, JsonReader& reader) {
+    std::string key;
+
+    reader.beginArray();
+    while (reader.nextElement()) {
+        asset.scenes.emplace_back();
+        Scene& scene = asset.scenes.back();
+
+        reader.beginObject();
+        while (reader.nextMember(key)) {
+            if (key == "name") {
+                reader.readString(scene.name);
+            } else if (key == "nodes") {
+                reader.beginArray();
+                while (reader.nextElement()) {
+                    scene.nodes.push_back(reader.readNumber<uint32_t>());
                 }
+            } else {
+                reader.skipValue();
             }
+        }
+    }
+}
 
-            // pbrMetallicRoughness.baseColorTexture
-            if (materials[i]["pbrMetallicRoughness"].find("baseColorTexture") != materials[i]["pbrMetallicRoughness"].end()) {
-                loadTextureInfo(asset.materials[i].pbr.baseColorTexture, materials[i]["pbrMetallicRoughness"]["baseColorTexture"]);
-            }
-
-            // pbrMetallicRoughness.metallicFactor
-            if (materials[i]["pbrMetallicRoughness"].find("metallicFactor") != materials[i]["pbrMetallicRoughness"].end()) {
-                if (!materials[i]["pbrMetallicRoughness"]["metallicFactor"].is_number()) {
-                    std::abort();
-                }
+static void loadPrimitive(Primitive& primitive, JsonReader& reader) {
+    bool hasAttributes = false;
+    std::string key;
+    std::string name;
+
+    reader.beginObject();
+    while (reader.nextMember(key)) {
+        if (key == "indices") {
+            primitive.indices = reader.readNumber<int32_t>();
+        } else if (key == "material") {
+            primitive.material = reader.readNumber<int32_t>();
+        } else if (key == "mode") {
+            primitive.mode = static_cast<Primitive::Mode>(reader.readNumber<uint8_t>());
+        } else if (key == "attributes") {
+            reader.beginObject();
+            while (reader.nextMember(name)) {
+                primitive.attributes[name] = reader.readNumber<uint32_t>();
+            }
+            hasAttributes = true;
+        } else {
+            // TODO: targets
+            reader.skipValue();
+        }
+    }
 
-                asset.materials[i].pbr.metallicFactor = materials[i]["pbrMetallicRoughness"]["metallicFactor"].get<float>();
-            }
+    if (!hasAttributes) {
+        std::abort();
+    }
+}
 
-            // pbrMetallicRoughness.roughnessFactor
-            if (materials[i]["pbrMetallicRoughness"].find("roughnessFactor") != materials[i]["pbrMetallicRoughness"].end()) {
-                if (!materials[i]["pbrMetallicRoughness"]["roughnessFactor"].is_number()) {
-                    std::abort();
+static void loadMeshes(Asset& asset, JsonReader& reader) {
+    std::string key;
+
+    reader.beginArray();
+    while (reader.nextElement()) {
+        asset.meshes.emplace_back();
+        Mesh& mesh = asset.meshes.back();
+        bool hasPrimitives = false;
+
+        reader.beginObject();
+        while (reader.nextMember(key)) {
+            if (key == "name") {
+                reader.readString(mesh.name);
+            } else if (key == "primitives") {
+                reader.beginArray();
+                while (reader.nextElement()) {
+                    mesh.primitives.emplace_back();
+                    loadPrimitive(mesh.primitives.back(), reader);
                 }
-
-                asset.materials[i].pbr.roughnessFactor = materials[i]["pbrMetallicRoughness"]["roughnessFactor"].get<float>();
-            }
-
-            // pbrMetallicRoughness.metallicRoughnessTexture
-            if (materials[i]["pbrMetallicRoughness"].find("metallicRoughnessTexture") != materials[i]["pbrMetallicRoughness"].end()) {
-                loadTextureInfo(asset.materials[i].pbr.metallicRoughnessTexture, materials[i]["pbrMetallicRoughness"]["metallicRoughnessTexture"]);
+                hasPrimitives = true;
+            } else {
+                // TODO: weights, extensions
+                reader.skipValue();
             }
         }
 
-        // normalTexture
-        if (materials[i].find("normalTexture") != materials[i].end()) {
-            loadTextureInfo(asset.materials[i].normalTexture, materials[i]["normalTexture"]);
+        if (!hasPrimitives) {
+            std::abort();
+        }
+    }
+}
 
-            // scale
-            if (materials[i]["normalTexture"].find("scale") != materials[i]["normalTexture"].end()) {
-                if (!materials[i]["normalTexture"]["scale"].is_number()) {
-                    std::abort();
+static void loadNodes(Asset& asset, JsonReader& reader) {
+    std::string key;
+
+    reader.beginArray();
+    while (reader.nextElement()) {
+        asset.nodes.emplace_back();
+        Node& node = asset.nodes.back();
+
+        reader.beginObject();
+        while (reader.nextMember(key)) {
+            if (key == "name") {
+                reader.readString(node.name);
+            } else if (key == "camera") {
+                node.camera = reader.readNumber<int32_t>();
+            } else if (key == "children") {
+                reader.beginArray();
+                while (reader.nextElement()) {
+                    node.children.push_back(reader.readNumber<uint32_t>());
                 }
+            } else if (key == "skin") {
+                node.skin = reader.readNumber<int32_t>();
+            } else if (key == "matrix") {
+                reader.readNumbers(node.matrix, 16);
+            } else if (key == "mesh") {
+                node.mesh = reader.readNumber<int32_t>();
+            } else if (key == "translation") {
+                reader.readNumbers(node.translation, 3);
+            } else if (key == "rotation") {
+                reader.readNumbers(node.rotation, 4);
+            } else if (key == "scale") {
+                reader.readNumbers(node.scale, 3);
+            } else {
+                // TODO: weights
+                reader.skipValue();
             }
         }
+    }
+}
 
-        // occlusionTexture
-        if (materials[i].find("occlusionTexture") != materials[i].end()) {
-            loadTextureInfo(asset.materials[i].occlusionTexture, materials[i]["occlusionTexture"]);
-
-            // scale
-            if (materials[i]["occlusionTexture"].find("strength") != materials[i]["occlusionTexture"].end()) {
-                if (!materials[i]["occlusionTexture"]["strength"].is_number()) {
-                    std::abort();
-                }
+static void loadBuffers(Asset& asset, JsonReader& reader, const LoadContext& context) {
+    std::string key;
+
+    reader.beginArray();
+    while (reader.nextElement()) {
+        asset.buffers.emplace_back();
+        Buffer& buffer = asset.buffers.back();
+        bool hasByteLength = false;
+
+        reader.beginObject();
+        while (reader.nextMember(key)) {
+            if (key == "name") {
+                reader.readString(buffer.name);
+            } else if (key == "byteLength") {
+                buffer.byteLength = reader.readNumber<uint32_t>();
+                hasByteLength = true;
+            } else if (key == "uri") {
+                reader.readString(buffer.uri);
+            } else {
+                reader.skipValue();
             }
         }
 
-        // emissiveTexture
-        if (materials[i].find("emissiveTexture") != materials[i].end()) {
-            loadTextureInfo(asset.materials[i].emissiveTexture, materials[i]["emissiveTexture"]);
+        if (!hasByteLength) {
+            std::abort();
         }
 
-        // emissiveFactor
-        if (materials[i].find("emissiveFactor") != materials[i].end()) {
-            if (!materials[i]["emissiveFactor"].is_array()) {
-                std::abort();
-            }
+        // The whole buffer object is known, its data can be loaded right away.
+        loadBufferData(asset, buffer, context);
+    }
+}
 
-            if (materials[i]["emissiveFactor"].size() != 3) {
-                std::abort();
+static void loadBufferViews(Asset& asset, JsonReader& reader) {
+    std::string key;
+
+    reader.beginArray();
+    while (reader.nextElement()) {
+        asset.bufferViews.emplace_back();
+        BufferView& bufferView = asset.bufferViews.back();
+        bool hasBuffer = false;
+        bool hasByteOffset = false;
+        bool hasByteLength = false;
+
+        reader.beginObject();
+        while (reader.nextMember(key)) {
+            if (key == "name") {
+                reader.readString(bufferView.name);
+            } else if (key == "buffer") {
+                bufferView.buffer = reader.readNumber<uint32_t>();
+                hasBuffer = true;
+            } else if (key == "byteOffset") {
+                bufferView.byteOffset = reader.readNumber<uint32_t>();
+                hasByteOffset = true;
+            } else if (key == "byteLength") {
+                bufferView.byteLength = reader.readNumber<uint32_t>();
+                hasByteLength = true;
+            } else if (key == "byteStride") {
+                bufferView.byteStride = reader.readNumber<uint32_t>();
+            } else if (key == "target") {
+                bufferView.target = static_cast<BufferView::TargetType>(reader.readNumber<uint16_t>());
+            } else {
+                // TODO: extensions, extras
+                reader.skipValue();
             }
+        }
 
-            for (uint32_t j = 0; j < 3; ++j) {
-                if (!materials[i]["emissiveFactor"][j].is_number()) {
-                    std::abort();
-                }
-
-                asset.materials[i].emissiveFactor[j] = materials[i]["emissiveFactor"][j].get<float>();
-            }
+        if (!hasBuffer || !hasByteOffset || !hasByteLength) {
+            std::abort();
         }
+    }
+}
 
-        // alphaMode
-        if (materials[i].find("alphaMode") != materials[i].end()) {
-            if (!materials[i]["alphaMode"].is_string()) {
-                std::abort();
-            }
+static Accessor::Type parseAccessorType(const std::string& type) {
+    if (type == "SCALAR") {
+        return Accessor::Type::Scalar;
+    } else if (type == "VEC2") {
+        return Accessor::Type::Vec2;
+    } else if (type == "VEC3") {
+        return Accessor::Type::Vec3;
+    } else if (type == "VEC4") {
+        return Accessor::Type::Vec4;
+    } else if (type == "MAT2") {
+        return Accessor::Type::Mat2;
+    } else if (type == "MAT3") {
+        return Accessor::Type::Mat3;
+    } else if (type == "MAT4") {
+        return Accessor::Type::Mat4;
+    }
+    std::abort();
+}
 
-            std::string type = materials[i]["alphaMode"].get<std::string>();
-            if (type == "OPAQUE") {
-                asset.materials[i].alphaMode = Material::AlphaMode::Opaque;
-            } else if (type == "MASK") {
-                asset.materials[i].alphaMode = Material::AlphaMode::Mask;
-            } else if (type == "BLEND") {
-                asset.materials[i].alphaMode = Material::AlphaMode::Blend;
+static void loadAccessors(Asset& asset, JsonReader& reader) {
+    std::string key;
+    std::string type;
+
+    reader.beginArray();
+    while (reader.nextElement()) {
+        asset.accessors.emplace_back();
+        Accessor& accessor = asset.accessors.back();
+        bool hasComponentType = false;
+        bool hasCount = false;
+        bool hasType = false;
+
+        reader.beginObject();
+        while (reader.nextMember(key)) {
+            if (key == "bufferView") {
+                accessor.bufferView = reader.readNumber<int32_t>();
+            } else if (key == "byteOffset") {
+                accessor.byteOffset = reader.readNumber<uint32_t>();
+            } else if (key == "componentType") {
+                accessor.componentType = static_cast<Accessor::ComponentType>(reader.readNumber<uint16_t>());
+                hasComponentType = true;
+            } else if (key == "normalized") {
+                accessor.normalized = reader.readBool();
+            } else if (key == "count") {
+                accessor.count = reader.readNumber<uint32_t>();
+                hasCount = true;
+            } else if (key == "type") {
+                reader.readString(type);
+                accessor.type = parseAccessorType(type);
+                hasType = true;
+            } else if (key == "name") {
+                reader.readString(accessor.name);
             } else {
-                std::abort();
-            }
-        }
-
-        // alphaCutoff
-        if (materials[i].find("alphaCutoff") != materials[i].end()) {
-            if (!materials[i]["alphaCutoff"].is_number()) {
-                std::abort();
+                // TODO: sparse, extensions, min, max
+                reader.skipValue();
             }
-
-            asset.materials[i].alphaCutoff = materials[i]["alphaCutoff"].get<float>();
         }
 
-        // doubleSided
-        if (materials[i].find("doubleSided") != materials[i].end()) {
-            if (!materials[i]["doubleSided"].is_boolean()) {
-                std::abort();
-            }
-
-            asset.materials[i].doubleSided = materials[i]["doubleSided"].get<bool>();
+        if (!hasComponentType || !hasCount || !hasType) {
+            std::abort();
         }
-
-        // TODO: materials[i]["extensions"]
-        // TODO: materials[i]["extras"]
     }
 }
 
-static void loadTextureInfo(Material::Texture& texture, nlohmann::json& json) {
-    if (!json.is_object()) {
-        std::abort();
+static void loadTextureInfo(Material::Texture& texture, JsonReader& reader, const char* factorName, float* factor) {
+    bool hasIndex = false;
+    std::string key;
+
+    reader.beginObject();
+    while (reader.nextMember(key)) {
+        if (key == "index") {
+            texture.index = reader.readNumber<int32_t>();
+            hasIndex = true;
+        } else if (key == "texCoord") {
+            texture.texCoord = reader.readNumber<uint32_t>();
+        } else if (factorName && key == factorName) {
+            *factor = reader.readNumber<float>();
+        } else {
+            // TODO: extensions, extras
+            reader.skipValue();
+        }
     }
 
-    // index
-    if (json.find("index") == json.end()) {
+    if (!hasIndex) {
         std::abort();
     }
+}
 
-    if (!json["index"].is_number()) {
-        std::abort();
+static void loadPbrMetallicRoughness(Material::Pbr& pbr, JsonReader& reader) {
+    std::string key;
+
+    reader.beginObject();
+    while (reader.nextMember(key)) {
+        if (key == "baseColorFactor") {
+            reader.readNumbers(pbr.baseColorFactor, 4);
+        } else if (key == "baseColorTexture") {
+            loadTextureInfo(pbr.baseColorTexture, reader, nullptr, nullptr);
+        } else if (key == "metallicFactor") {
+            pbr.metallicFactor = reader.readNumber<float>();
+        } else if (key == "roughnessFactor") {
+            pbr.roughnessFactor = reader.readNumber<float>();
+        } else if (key == "metallicRoughnessTexture") {
+            loadTextureInfo(pbr.metallicRoughnessTexture, reader, nullptr, nullptr);
+        } else {
+            reader.skipValue();
+        }
     }
+}
 
-    texture.index = json["index"].get<int32_t>();
-
-    // texCoord
-    if (json.find("texCoord") != json.end()) {
-        if (!json["texCoord"].is_number()) {
-            std::abort();
+static void loadMaterials(Asset& asset, JsonReader& reader) {
+    std::string key;
+    std::string alphaMode;
+
+    reader.beginArray();
+    while (reader.nextElement()) {
+        asset.materials.emplace_back();
+        Material& material = asset.materials.back();
+
+        reader.beginObject();
+        while (reader.nextMember(key)) {
+            if (key == "name") {
+                reader.readString(material.name);
+            } else if (key == "pbrMetallicRoughness") {
+                loadPbrMetallicRoughness(material.pbr, reader);
+            } else if (key == "normalTexture") {
+                loadTextureInfo(material.normalTexture, reader, "scale", &material.normalTexture.scale);
+            } else if (key == "occlusionTexture") {
+                loadTextureInfo(material.occlusionTexture, reader, "strength", &material.occlusionTexture.strength);
+            } else if (key == "emissiveTexture") {
+                loadTextureInfo(material.emissiveTexture, reader, nullptr, nullptr);
+            } else if (key == "emissiveFactor") {
+                reader.readNumbers(material.emissiveFactor, 3);
+            } else if (key == "alphaMode") {
+                reader.readString(alphaMode);
+                if (alphaMode == "OPAQUE") {
+                    material.alphaMode = Material::AlphaMode::Opaque;
+                } else if (alphaMode == "MASK") {
+                    material.alphaMode = Material::AlphaMode::Mask;
+                } else if (alphaMode == "BLEND") {
+                    material.alphaMode = Material::AlphaMode::Blend;
+                } else {
+                    std::abort();
+                }
+            } else if (key == "alphaCutoff") {
+                material.alphaCutoff = reader.readNumber<float>();
+            } else if (key == "doubleSided") {
+                material.doubleSided = reader.readBool();
+            } else {
+                // TODO: extensions, extras
+                reader.skipValue();
+            }
         }
-
-        texture.texCoord = json["texCoord"].get<int32_t>();
     }
-
-    // TODO: json["extensions"]
-    // TODO: json["extras"]
 }
 
-static void loadImages(Asset& asset, nlohmann::json& json) {
-    if (json.find("images") == json.end()) {
+static void loadImageData(Asset& asset, Image& image, const std::string& uri, const LoadContext& context) {
+    if (isDataUri(uri)) {
+        // An explicit mimeType takes precedence over the one of the data uri.
+        std::string mimeType;
+        image.storage = decodeDataUri(uri, mimeType, image.byteLength);
+        if (!image.storage) {
+            std::abort();
+        }
+        image.data = image.storage.get();
+        if (image.mimeType.empty()) {
+            image.mimeType = mimeType;
+        }
         return;
     }
 
-    auto& images = json["images"];
-    if (!images.is_array()) {
-        std::abort();
+    if (asset.dirName.empty()) {
+        image.uri = uri;
+    } else {
+        image.uri = pathAppend(asset.dirName, uri);
     }
 
-    asset.images.resize(images.size());
-    for (uint32_t i = 0; i < images.size(); ++i) {
-        // name
-        if (images[i].find("name") != images[i].end()) {
-            if (!images[i]["name"].is_string()) {
-                std::abort();
-            }
-
-            asset.images[i].name = images[i]["name"];
-        }
-
-        // uri
-        // TODO: load base64 uri
-        if (images[i].find("uri") != images[i].end()) {
-            if (!images[i]["uri"].is_string()) {
-                std::abort();
-            }
-
-            asset.images[i].uri = pathAppend(asset.dirName, images[i]["uri"]);
-        }
-
-        // mimeType
-        if (images[i].find("mimeType") != images[i].end()) {
-            if (!images[i]["mimeType"].is_string()) {
-                std::abort();
-            }
-
-            asset.images[i].mimeType = images[i]["mimeType"];
-        }
+    // Images are optional, unresolved ones are left empty.
+    if (context.resolver) {
+        (*context.resolver)(image.uri, image.data, image.byteLength);
+    }
+}
 
-        // bufferView
-        if (images[i].find("bufferView") != images[i].end()) {
-            if (!images[i]["bufferView"].is_number()) {
-                std::abort();
+static void loadImages(Asset& asset, JsonReader& reader, const LoadContext& context) {
+    std::string key;
+    std::string uri;
+
+    reader.beginArray();
+    while (reader.nextElement()) {
+        asset.images.emplace_back();
+        Image& image = asset.images.back();
+        bool hasUri = false;
+
+        reader.beginObject();
+        while (reader.nextMember(key)) {
+            if (key == "name") {
+                reader.readString(image.name);
+            } else if (key == "uri") {
+                reader.readString(uri);
+                hasUri = true;
+            } else if (key == "mimeType") {
+                reader.readString(image.mimeType);
+            } else if (key == "bufferView") {
+                image.bufferView = reader.readNumber<int32_t>();
+            } else {
+                // TODO: extensions, extras
+                reader.skipValue();
             }
-
-            asset.images[i].bufferView = images[i]["bufferView"].get<int32_t>();
         }
 
         // TODO: Handle dependencies between mimeType and bufferView
         // TODO: Handle the fact that we want an uri OR a bufferView
-        // TODO: images[i]["extensions"]
-        // TODO: images[i]["extras"]
+        if (hasUri) {
+            loadImageData(asset, image, uri, context);
+        }
     }
 }
 
-static void loadSamplers(Asset& asset, nlohmann::json& json) {
-    if (json.find("samplers") == json.end()) {
-        return;
-    }
-
-    auto& samplers = json["samplers"];
-    if (!samplers.is_array()) {
-        std::abort();
-    }
-
-    asset.samplers.resize(samplers.size());
-    for (uint32_t i = 0; i < samplers.size(); ++i) {
-        // name
-        if (samplers[i].find("name") != samplers[i].end()) {
-            if (!samplers[i]["name"].is_string()) {
-                std::abort();
+static void loadSamplers(Asset& asset, JsonReader& reader) {
+    std::string key;
+
+    reader.beginArray();
+    while (reader.nextElement()) {
+        asset.samplers.emplace_back();
+        Sampler& sampler = asset.samplers.back();
+
+        reader.beginObject();
+        while (reader.nextMember(key)) {
+            if (key == "name") {
+                reader.readString(sampler.name);
+            } else if (key == "magFilter") {
+                sampler.magFilter = static_cast<Sampler::MagFilter>(reader.readNumber<uint16_t>());
+            } else if (key == "minFilter") {
+                sampler.minFilter = static_cast<Sampler::MinFilter>(reader.readNumber<uint16_t>());
+            } else if (key == "wrapS") {
+                sampler.wrapS = static_cast<Sampler::WrappingMode>(reader.readNumber<uint16_t>());
+            } else if (key == "wrapT") {
+                sampler.wrapT = static_cast<Sampler::WrappingMode>(reader.readNumber<uint16_t>());
+            } else {
+                // TODO: extensions, extras
+                reader.skipValue();
             }
-
-            asset.samplers[i].name = samplers[i]["name"];
         }
+    }
+}
 
-        // magFilter
-        if (samplers[i].find("magFilter") != samplers[i].end()) {
-            if (!samplers[i]["magFilter"].is_number()) {
-                std::abort();
+static void loadTextures(Asset& asset, JsonReader& reader) {
+    std::string key;
+
+    reader.beginArray();
+    while (reader.nextElement()) {
+        asset.textures.emplace_back();
+        Texture& texture = asset.textures.back();
+
+        reader.beginObject();
+        while (reader.nextMember(key)) {
+            if (key == "name") {
+                reader.readString(texture.name);
+            } else if (key == "sampler") {
+                texture.sampler = reader.readNumber<int32_t>();
+            } else if (key == "source") {
+                texture.source = reader.readNumber<int32_t>();
+            } else {
+                // TODO: extensions, extras
+                reader.skipValue();
             }
-
-            asset.samplers[i].magFilter = static_cast<Sampler::MagFilter>(samplers[i]["magFilter"].get<uint16_t>());
         }
+    }
+}
 
-        // minFilter
-        if (samplers[i].find("minFilter") != samplers[i].end()) {
-            if (!samplers[i]["minFilter"].is_number()) {
-                std::abort();
-            }
-
-            asset.samplers[i].minFilter = static_cast<Sampler::MinFilter>(samplers[i]["minFilter"].get<uint16_t>());
+static void loadDocument(Asset& asset, const char* data, size_t size, const LoadContext& context) {
+    // Single pass over the JSON text, every top-level property is loaded
+    // into the asset as soon as it is read, whatever their order.
+    JsonReader reader(data, size);
+    bool hasAsset = false;
+    bool hasScenes = false;
+    std::string key;
+
+    reader.beginObject();
+    while (reader.nextMember(key)) {
+        if (key == "asset") {
+            loadAsset(asset, reader);
+            hasAsset = true;
+        } else if (key == "extensionsUsed") {
+            loadStrings(asset.extensionsUsed, reader);
+        } else if (key == "extensionsRequired") {
+            loadStrings(asset.extensionRequired, reader);
+        } else if (key == "scene") {
+            asset.scene = reader.readNumber<int32_t>();
+        } else if (key == "scenes") {
+            loadScenes(asset, reader);
+            hasScenes = true;
+        } else if (key == "meshes") {
+            loadMeshes(asset, reader);
+        } else if (key == "nodes") {
+            loadNodes(asset, reader);
+        } else if (key == "buffers") {
+            loadBuffers(asset, reader, context);
+        } else if (key == "bufferViews") {
+            loadBufferViews(asset, reader);
+        } else if (key == "accessors") {
+            loadAccessors(asset, reader);
+        } else if (key == "materials") {
+            loadMaterials(asset, reader);
+        } else if (key == "images") {
+            loadImages(asset, reader, context);
+        } else if (key == "samplers") {
+            loadSamplers(asset, reader);
+        } else if (key == "textures") {
+            loadTextures(asset, reader);
+        } else {
+            // TODO: animations, cameras, skins, extensions, extras
+            reader.skipValue();
         }
+    }
+    reader.finish();
 
-        // wrapS
-        if (samplers[i].find("wrapS") != samplers[i].end()) {
-            if (!samplers[i]["wrapS"].is_number()) {
-                std::abort();
-            }
-
-            asset.samplers[i].wrapS = static_cast<Sampler::WrappingMode>(samplers[i]["wrapS"].get<uint16_t>());
-        }
+    if (!hasAsset) {
+        std::abort();
+    }
 
-        // wrapT
-        if (samplers[i].find("wrapT") != samplers[i].end()) {
-            if (!samplers[i]["wrapT"].is_number()) {
-                std::abort();
-            }
+    if (hasScenes && asset.scene == -1) {
+        asset.scene = 0;
+    }
+}
 
-            asset.samplers[i].wrapT = static_cast<Sampler::WrappingMode>(samplers[i]["wrapT"].get<uint16_t>());
-        }
+static const uint32_t GLB_MAGIC = 0x46546C67; // "glTF"
+static const uint32_t GLB_VERSION = 2;
+static const uint32_t GLB_CHUNK_JSON = 0x4E4F534A; // "JSON"
+static const uint32_t GLB_CHUNK_BIN = 0x004E4942; // "BIN\0"
+static const size_t GLB_HEADER_SIZE = 12;
+static const size_t GLB_CHUNK_HEADER_SIZE = 8;
+
+static uint32_t readUint32(const char* data) {
+    // .glb is little-endian, like every platform we build for.
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
 
-        // TODO: samplers[i]["extensions"]
-        // TODO: samplers[i]["extras"]
-    }
+static bool isGlb(const char* data, size_t size) {
+    return size >= GLB_HEADER_SIZE && readUint32(data) == GLB_MAGIC;
 }
 
-static void loadTextures(Asset& asset, nlohmann::json& json) {
-    if (json.find("textures") == json.end()) {
-        return;
+static void loadGlb(Asset& asset, const char* data, size_t size, LoadContext& context) {
+    if (!isGlb(data, size) || readUint32(data + 4) != GLB_VERSION) {
+        std::abort();
     }
 
-    auto& textures = json["textures"];
-    if (!textures.is_array()) {
+    size_t length = readUint32(data + 8);
+    if (length > size) {
         std::abort();
     }
 
-    asset.textures.resize(textures.size());
-    for (uint32_t i = 0; i < textures.size(); ++i) {
-        // name
-        if (textures[i].find("name") != textures[i].end()) {
-            if (!textures[i]["name"].is_string()) {
-                std::abort();
-            }
-
-            asset.textures[i].name = textures[i]["name"];
-        }
-
-        // sampler
-        if (textures[i].find("sampler") != textures[i].end()) {
-            if (!textures[i]["sampler"].is_number()) {
-                std::abort();
-            }
+    // The JSON chunk always comes first.
+    size_t offset = GLB_HEADER_SIZE;
+    if (offset + GLB_CHUNK_HEADER_SIZE > length) {
+        std::abort();
+    }
+    size_t jsonLength = readUint32(data + offset);
+    if (readUint32(data + offset + 4) != GLB_CHUNK_JSON || offset + GLB_CHUNK_HEADER_SIZE + jsonLength > length) {
+        std::abort();
+    }
+    const char* jsonData = data + offset + GLB_CHUNK_HEADER_SIZE;
+    offset += GLB_CHUNK_HEADER_SIZE + jsonLength;
 
-            asset.textures[i].sampler = textures[i]["sampler"].get<int32_t>();
+    // The BIN chunk is optional, buffers point into it without copying.
+    if (offset + GLB_CHUNK_HEADER_SIZE <= length && readUint32(data + offset + 4) == GLB_CHUNK_BIN) {
+        size_t binLength = readUint32(data + offset);
+        if (offset + GLB_CHUNK_HEADER_SIZE + binLength > length) {
+            std::abort();
         }
+        context.binChunk = data + offset + GLB_CHUNK_HEADER_SIZE;
+        context.binChunkSize = binLength;
+    }
 
-        // source
-        if (textures[i].find("source") != textures[i].end()) {
-            if (!textures[i]["source"].is_number()) {
-                std::abort();
-            }
+    loadDocument(asset, jsonData, jsonLength, context);
+}
 
-            asset.textures[i].source = textures[i]["source"].get<int32_t>();
-        }
+static bool hasGlbExtension(const std::string& fileName) {
+    static const std::string extension = ".glb";
+    return fileName.size() >= extension.size()
+        && fileName.compare(fileName.size() - extension.size(), extension.size(), extension) == 0;
+}
 
-        // TODO: textures[i]["extensions"]
-        // TODO: textures[i]["extras"]
+static size_t getFileSize(const std::string& fileName) {
+    std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        std::abort();
     }
+    return static_cast<size_t>(file.tellg());
 }
 
 Asset load(std::string fileName) {
-    // TODO: Check the extension (.gltf / .glb)
+    Asset asset{};
 
-    nlohmann::json json;
+    asset.dirName = getDirectoryName(fileName);
 
-    {
-        std::ifstream file(fileName);
+    if (hasGlbExtension(fileName)) {
+        size_t size = getFileSize(fileName);
 
-        if (!file.is_open()) {
+        LoadContext context;
+        context.glbStorage = mapFile(fileName, size);
+        if (!context.glbStorage) {
+            context.glbStorage = readFile(fileName, size);
+        }
+        if (!context.glbStorage) {
             std::abort();
         }
 
-        file >> json;
+        loadGlb(asset, context.glbStorage.get(), size, context);
+        return asset;
+    }
+
+    // The JSON is parsed straight from the file mapping.
+    size_t size = getFileSize(fileName);
+    std::shared_ptr<const char> json = mapFile(fileName, size);
+    if (!json) {
+        json = readFile(fileName, size);
     }
+    if (!json) {
+        std::abort();
+    }
+
+    loadDocument(asset, json.get(), size, LoadContext());
 
+    return asset;
+}
+
+Asset load(const char* data, size_t size, const ResourceResolver& resolver) {
+    // Image uris are left relative, the caller resolves them.
     Asset asset{};
 
-    asset.dirName = getDirectoryName(fileName);
+    LoadContext context;
+    context.resolver = &resolver;
+
+    if (isGlb(data, size)) {
+        loadGlb(asset, data, size, context);
+        return asset;
+    }
 
-    loadAsset(asset, json);
-    loadScenes(asset, json);
-    loadMeshes(asset, json);
-    loadNodes(asset, json);
-    loadBuffers(asset, json);
-    loadBufferViews(asset, json);
-    loadAccessors(asset, json);
-    loadMaterials(asset, json);
-    loadImages(asset, json);
-    loadSamplers(asset, json);
-    loadTextures(asset, json);
+    loadDocument(asset, data, size, context);
 
     return asset;
 }
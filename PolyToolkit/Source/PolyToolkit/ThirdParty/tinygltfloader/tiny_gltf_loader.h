@@ -36,7 +36,7 @@
 // Tiny glTF loader is using following third party libraries:
 //
 //  - picojson: C++ JSON library.
-//  - base64: base64 decode/encode library.
+//  - base64: base64 decoder shared with gltf2-loader.
 //
 #ifndef TINY_GLTF_LOADER_H_
 #define TINY_GLTF_LOADER_H_
@@ -514,13 +514,32 @@ enum SectionCheck {
   REQUIRE_ALL = 0x3f
 };
 
+/// Reads the contents of an external file (e.g. a .bin buffer) referenced by
+/// the glTF asset. Returns false if the file is not available.
+typedef bool (*ReadExternalFileFunction)(std::vector<unsigned char> *out,
+                                         const std::string &filename,
+                                         void *user_data);
+
 class TinyGLTFLoader {
  public:
-  TinyGLTFLoader() : bin_data_(NULL), bin_size_(0), is_binary_(false) {
+  TinyGLTFLoader()
+      : bin_data_(NULL),
+        bin_size_(0),
+        read_file_(NULL),
+        read_file_user_data_(NULL),
+        is_binary_(false) {
     pad[0] = pad[1] = pad[2] = pad[3] = pad[4] = pad[5] = pad[6] = 0;
   }
   ~TinyGLTFLoader() {}
 
+  /// Sets a function used to read external files instead of reading them
+  /// from `base_dir`. Pass NULL to restore the default file system access.
+  void SetReadExternalFileFunction(ReadExternalFileFunction read_file,
+                                   void *user_data) {
+    read_file_ = read_file;
+    read_file_user_data_ = user_data;
+  }
+
   /// Loads glTF ASCII asset from a file.
   /// Returns false and set error string to `err` if there's an error.
   bool LoadASCIIFromFile(Scene *scene, std::string *err,
@@ -560,6 +579,8 @@ class TinyGLTFLoader {
 
   const unsigned char *bin_data_;
   size_t bin_size_;
+  ReadExternalFileFunction read_file_;
+  void *read_file_user_data_;
   bool is_binary_;
   char pad[7];
 };
@@ -574,6 +595,8 @@ class TinyGLTFLoader {
 #include <fstream>
 #include <sstream>
 
+#include "gltf2/Base64.hpp"
+
 #ifdef __clang__
 // Disable some warnings for external files.
 #pragma clang diagnostic push
@@ -743,107 +766,37 @@ static std::string GetBaseDir(const std::string &filepath) {
   return "";
 }
 
-// std::string base64_encode(unsigned char const* , unsigned int len);
-std::string base64_decode(std::string const &s);
-
-/*
-   base64.cpp and base64.h
-
-   Copyright (C) 2004-2008 René Nyffenegger
-
-   This source code is provided 'as-is', without any express or implied
-   warranty. In no event will the author be held liable for any damages
-   arising from the use of this software.
-
-   Permission is granted to anyone to use this software for any purpose,
-   including commercial applications, and to alter it and redistribute it
-   freely, subject to the following restrictions:
-
-   1. The origin of this source code must not be misrepresented; you must not
-      claim that you wrote the original source code. If you use this source code
-      in a product, an acknowledgment in the product documentation would be
-      appreciated but is not required.
-
-   2. Altered source versions must be plainly marked as such, and must not be
-      misrepresented as being the original source code.
-
-   3. This notice may not be removed or altered from any source distribution.
-
-   René Nyffenegger rene.nyffenegger@adp-gmbh.ch
-
-*/
-
-#ifdef __clang__
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wexit-time-destructors"
-#pragma clang diagnostic ignored "-Wglobal-constructors"
-#pragma clang diagnostic ignored "-Wsign-conversion"
-#pragma clang diagnostic ignored "-Wconversion"
-#endif
-static const std::string base64_chars =
-    "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-    "abcdefghijklmnopqrstuvwxyz"
-    "0123456789+/";
-
-static inline bool is_base64(unsigned char c) {
-  return (isalnum(c) || (c == '+') || (c == '/'));
-}
-
-std::string base64_decode(std::string const &encoded_string) {
-  int in_len = static_cast<int>(encoded_string.size());
-  int i = 0;
-  int j = 0;
-  int in_ = 0;
-  unsigned char char_array_4[4], char_array_3[3];
-  std::string ret;
-
-  while (in_len-- && (encoded_string[in_] != '=') &&
-         is_base64(encoded_string[in_])) {
-    char_array_4[i++] = encoded_string[in_];
-    in_++;
-    if (i == 4) {
-      for (i = 0; i < 4; i++)
-        char_array_4[i] =
-            static_cast<unsigned char>(base64_chars.find(char_array_4[i]));
-
-      char_array_3[0] =
-          (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-      char_array_3[1] =
-          ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-      char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
+static bool LoadExternalFile(std::vector<unsigned char> *out, std::string *err,
+                             const std::string &filename,
+                             const std::string &basedir, size_t reqBytes,
+                             bool checkSize,
+                             ReadExternalFileFunction read_file = NULL,
+                             void *read_file_user_data = NULL) {
+  out->clear();
 
-      for (i = 0; (i < 3); i++) ret += char_array_3[i];
-      i = 0;
+  if (read_file) {
+    std::vector<unsigned char> buf;
+    if (!read_file(&buf, filename, read_file_user_data)) {
+      if (err) {
+        (*err) += "File not found : " + filename + "\n";
+      }
+      return false;
     }
-  }
-
-  if (i) {
-    for (j = i; j < 4; j++) char_array_4[j] = 0;
 
-    for (j = 0; j < 4; j++)
-      char_array_4[j] =
-          static_cast<unsigned char>(base64_chars.find(char_array_4[j]));
-
-    char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-    char_array_3[1] =
-        ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-    char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
+    if (checkSize && reqBytes != buf.size()) {
+      std::stringstream ss;
+      ss << "File size mismatch : " << filename << ", requestedBytes "
+         << reqBytes << ", but got " << buf.size() << std::endl;
+      if (err) {
+        (*err) += ss.str();
+      }
+      return false;
+    }
 
-    for (j = 0; (j < i - 1); j++) ret += char_array_3[j];
+    out->swap(buf);
+    return true;
   }
 
-  return ret;
-}
-#ifdef __clang__
-#pragma clang diagnostic pop
-#endif
-
-static bool LoadExternalFile(std::vector<unsigned char> *out, std::string *err,
-                             const std::string &filename,
-                             const std::string &basedir, size_t reqBytes,
-                             bool checkSize) {
-  out->clear();
-
   std::vector<std::string> paths;
   paths.push_back(basedir);
   paths.push_back(".");
@@ -919,47 +872,26 @@ static bool IsDataURI(const std::string &in) {
 static bool DecodeDataURI(std::vector<unsigned char> *out,
                           const std::string &in, size_t reqBytes,
                           bool checkSize) {
-  std::string header = "data:application/octet-stream;base64,";
-  std::string data;
-  if (in.find(header) == 0) {
-    data = base64_decode(in.substr(header.size()));  // cut mime string.
-  }
-
-  if (data.empty()) {
-    header = "data:image/jpeg;base64,";
-    if (in.find(header) == 0) {
-      data = base64_decode(in.substr(header.size()));  // cut mime string.
-    }
-  }
-
-  if (data.empty()) {
-    header = "data:image/png;base64,";
-    if (in.find(header) == 0) {
-      data = base64_decode(in.substr(header.size()));  // cut mime string.
-    }
+  std::string mime_type;
+  size_t offset = 0;
+  if (!gltf2::base64::parseDataUri(in, mime_type, offset)) {
+    return false;
   }
 
-  if (data.empty()) {
-    header = "data:text/plain;base64,";
-    if (in.find(header) == 0) {
-      data = base64_decode(in.substr(header.size()));
-    }
+  // Decode straight into the output, without an intermediate string.
+  const char *src = in.data() + offset;
+  size_t length = in.size() - offset;
+  size_t size = gltf2::base64::decodedSize(src, length);
+  if (size == 0) {
+    return false;
   }
-
-  if (data.empty()) {
+  if (checkSize && size != reqBytes) {
     return false;
   }
 
-  if (checkSize) {
-    if (data.size() != reqBytes) {
-      return false;
-    }
-    out->resize(reqBytes);
-  } else {
-    out->resize(data.size());
-  }
-  std::copy(data.begin(), data.end(), out->begin());
-  return true;
+  out->resize(size);
+  return gltf2::base64::decode(src, length,
+                               reinterpret_cast<char *>(&out->at(0)));
 }
 
 static void ParseObjectProperty(Value *ret, const picojson::object &o) {
@@ -1351,7 +1283,9 @@ static bool ParseBuffer(Buffer *buffer, std::string *err,
                         const picojson::object &o, const std::string &basedir,
                         bool is_binary = false,
                         const unsigned char *bin_data = NULL,
-                        size_t bin_size = 0) {
+                        size_t bin_size = 0,
+                        ReadExternalFileFunction read_file = NULL,
+                        void *read_file_user_data = NULL) {
   double byteLength;
   if (!ParseNumberProperty(&byteLength, err, o, "byteLength", true)) {
     return false;
@@ -1380,7 +1314,8 @@ static bool ParseBuffer(Buffer *buffer, std::string *err,
       loaded = DecodeDataURI(&buffer->data, uri, bytes, true);
     } else {
       // Assume external .bin file.
-      loaded = LoadExternalFile(&buffer->data, err, uri, basedir, bytes, true);
+      loaded = LoadExternalFile(&buffer->data, err, uri, basedir, bytes, true,
+                                read_file, read_file_user_data);
     }
 
     if (!loaded) {
@@ -1428,7 +1363,8 @@ static bool ParseBuffer(Buffer *buffer, std::string *err,
       }
     } else {
       // Assume external .bin file.
-      if (!LoadExternalFile(&buffer->data, err, uri, basedir, bytes, true)) {
+      if (!LoadExternalFile(&buffer->data, err, uri, basedir, bytes, true,
+                            read_file, read_file_user_data)) {
         return false;
       }
     }
@@ -2110,7 +2046,8 @@ bool TinyGLTFLoader::LoadFromString(Scene *scene, std::string *err,
     for (; it != itEnd; it++) {
       Buffer buffer;
       if (!ParseBuffer(&buffer, err, (it->second).get<picojson::object>(),
-                       base_dir, is_binary_, bin_data_, bin_size_)) {
+                       base_dir, is_binary_, bin_data_, bin_size_, read_file_,
+                       read_file_user_data_)) {
         return false;
       }
 